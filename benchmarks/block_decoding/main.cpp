@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include <cdfpp/cdf-io/compression.hpp>
+#include <cdfpp/cdf-io/loading/buffers.hpp>
+#include <cdfpp/cdf-io/loading/variable.hpp>
+#include <cdfpp/no_init_vector.hpp>
+#include <cstring>
+#include <numeric>
+
+inline constexpr std::size_t mega(std::size_t n)
+{
+    return n * 1024 * 1024;
+}
+
+/* a big endian, column major, 3D double variable stored as gzip CVVRs of 1024 records */
+struct compressed_variable
+{
+    static constexpr std::size_t records_per_block = 1024;
+    no_init_vector<uint32_t> shape;
+    std::size_t record_size;
+    std::vector<cdf::io::common::var_block_t> blocks;
+    decltype(cdf::io::buffers::make_shared_array_adapter(std::vector<char> {})) stream;
+
+    compressed_variable(std::size_t bytes)
+            : shape { static_cast<uint32_t>(bytes / (16 * 8 * sizeof(double))), 16, 8 }
+            , record_size { 16 * 8 * sizeof(double) }
+            , stream { cdf::io::buffers::make_shared_array_adapter(make_file()) }
+    {
+    }
+
+private:
+    std::vector<char> make_file()
+    {
+        std::vector<double> values(shape[0] * 16 * 8);
+        std::iota(std::begin(values), std::end(values), 0.);
+        std::vector<char> file;
+        for (std::size_t first = 0; first < shape[0]; first += records_per_block)
+        {
+            const auto last = std::min<std::size_t>(first + records_per_block, shape[0]);
+            no_init_vector<char> block((last - first) * record_size);
+            std::memcpy(block.data(), values.data() + first * 16 * 8, std::size(block));
+            cdf::endianness::decode_v<cdf::endianness::big_endian_t>(
+                reinterpret_cast<double*>(block.data()), std::size(block) / sizeof(double));
+            const auto compressed
+                = cdf::io::compression::deflate<cdf::cdf_compression_type::gzip_compression>(
+                    block);
+            blocks.push_back({ first, last - 1, std::size(file), std::size(compressed), true });
+            file.insert(std::end(file), std::cbegin(compressed), std::cend(compressed));
+        }
+        return file;
+    }
+};
+
+static void BM_three_passes(benchmark::State& state)
+{
+    compressed_variable var(state.range(0));
+    for (auto _ : state)
+    {
+        auto values = cdf::load_values<false>(
+            cdf::io::variable::load_var_data(var.stream, var.blocks, cdf::CDF_Types::CDF_DOUBLE,
+                var.record_size, var.shape[0], cdf::cdf_compression_type::gzip_compression),
+            cdf::cdf_encoding::network);
+        cdf::majority::swap(values, var.shape);
+        benchmark::DoNotOptimize(values);
+    }
+    state.SetBytesProcessed(
+        static_cast<int64_t>(state.iterations() * var.shape[0] * var.record_size));
+}
+BENCHMARK(BM_three_passes)->RangeMultiplier(4)->Range(mega(1), mega(64))->UseRealTime();
+
+static void BM_fused(benchmark::State& state)
+{
+    compressed_variable var(state.range(0));
+    const auto decoder = cdf::io::variable::block_decoder_t::make(cdf::CDF_Types::CDF_DOUBLE,
+        cdf::cdf_encoding::network, var.shape, var.record_size, cdf::cdf_majority::column);
+    for (auto _ : state)
+    {
+        auto values = cdf::io::variable::load_var_data(var.stream, var.blocks,
+            cdf::CDF_Types::CDF_DOUBLE, var.record_size, var.shape[0],
+            cdf::cdf_compression_type::gzip_compression, &*decoder);
+        benchmark::DoNotOptimize(values);
+    }
+    state.SetBytesProcessed(
+        static_cast<int64_t>(state.iterations() * var.shape[0] * var.record_size));
+}
+BENCHMARK(BM_fused)->RangeMultiplier(4)->Range(mega(1), mega(64))->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+#include <cdfpp/cdf-io/compression.hpp>
+#include <cdfpp/cdf-io/decompression.hpp>
+#include <cdfpp/no_init_vector.hpp>
+#include <cmath>
+#include <cstring>
+
+// Per block cost of gzip/zstd codecs, blocks sizes match what the NASA library writes
+// record by record (a few KB) up to large CVVRs.
+
+no_init_vector<char> make_data(std::size_t size)
+{
+    no_init_vector<char> data(size);
+    for (auto i = 0UL; i < size / sizeof(double); i++)
+    {
+        double v = std::cos(static_cast<double>(i) / 100.);
+        std::memcpy(data.data() + i * sizeof(double), &v, sizeof(double));
+    }
+    return data;
+}
+
+// what every block paid before codec contexts were kept per thread
+std::size_t fresh_context_gzinflate(
+    const no_init_vector<char>& input, char* output, std::size_t output_size)
+{
+#ifdef CDFpp_USE_LIBDEFLATE
+    auto decompressor = libdeflate_alloc_decompressor();
+    std::size_t length = 0;
+    auto result = libdeflate_gzip_decompress(
+        decompressor, input.data(), std::size(input), output, output_size, &length);
+    libdeflate_free_decompressor(decompressor);
+    return result == LIBDEFLATE_SUCCESS ? length : 0;
+#else
+    z_stream fstream;
+    fstream.zalloc = Z_NULL;
+    fstream.zfree = Z_NULL;
+    fstream.opaque = Z_NULL;
+    fstream.avail_in = std::size(input);
+    fstream.next_in = reinterpret_cast<const Bytef*>(input.data());
+    fstream.avail_out = output_size;
+    fstream.next_out = reinterpret_cast<Bytef*>(output);
+    if (Z_OK != inflateInit2(&fstream, 32 + MAX_WBITS))
+        return 0;
+    auto ret = inflate(&fstream, Z_FINISH);
+    inflateEnd(&fstream);
+    return ret == Z_STREAM_END ? output_size - fstream.avail_out : 0;
+#endif
+}
+
+static void BM_gzinflate_fresh_context(benchmark::State& state)
+{
+    auto data = make_data(state.range(0));
+    auto compressed = cdf::io::compression::gzdeflate(data);
+    no_init_vector<char> output(data.size());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fresh_context_gzinflate(compressed, output.data(), output.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_gzinflate_fresh_context)->RangeMultiplier(4)->Range(1024, 1024 * 1024);
+
+static void BM_gzinflate_thread_context(benchmark::State& state)
+{
+    auto data = make_data(state.range(0));
+    auto compressed = cdf::io::compression::gzdeflate(data);
+    no_init_vector<char> output(data.size());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            cdf::io::decompression::gzinflate(compressed, output.data(), output.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_gzinflate_thread_context)->RangeMultiplier(4)->Range(1024, 1024 * 1024);
+
+static void BM_gzdeflate_thread_context(benchmark::State& state)
+{
+    auto data = make_data(state.range(0));
+    for (auto _ : state)
+    {
+        auto result = cdf::io::compression::gzdeflate(data);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_gzdeflate_thread_context)->RangeMultiplier(4)->Range(1024, 1024 * 1024);
+
+#ifdef CDFPP_USE_ZSTD
+static void BM_zstd_inflate_fresh_context(benchmark::State& state)
+{
+    auto data = make_data(state.range(0));
+    auto compressed = cdf::io::zstd::deflate(data);
+    no_init_vector<char> output(data.size());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ZSTD_decompress(
+            output.data(), output.size(), compressed.data(), std::size(compressed)));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_zstd_inflate_fresh_context)->RangeMultiplier(4)->Range(1024, 1024 * 1024);
+
+static void BM_zstd_inflate_thread_context(benchmark::State& state)
+{
+    auto data = make_data(state.range(0));
+    auto compressed = cdf::io::zstd::deflate(data);
+    no_init_vector<char> output(data.size());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            cdf::io::zstd::inflate(compressed, output.data(), output.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_zstd_inflate_thread_context)->RangeMultiplier(4)->Range(1024, 1024 * 1024);
+#endif
+
+BENCHMARK_MAIN();
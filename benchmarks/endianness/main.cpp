@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+#include <cdfpp/cdf-io/endianness.hpp>
+#include <cdfpp/no_init_vector.hpp>
+#include <cstdint>
+#include <numeric>
+
+inline constexpr std::size_t mega(std::size_t n)
+{
+    return n * 1024 * 1024;
+}
+
+template <typename T>
+static void scalar_byte_swap(T* const data, std::size_t size)
+{
+    for (auto i = 0UL; i < size; i++)
+        data[i] = cdf::endianness::byte_swap(data[i]);
+}
+
+template <typename T>
+static void entry_point_byte_swap(T* const data, std::size_t size)
+{
+    cdf::endianness::decode_v<cdf::endianness::big_endian_t>(data, size);
+}
+
+template <typename T>
+static void BM_byte_swap(benchmark::State& state, void (*func)(T* const, std::size_t))
+{
+    no_init_vector<T> values(state.range(0));
+    std::iota(std::begin(values), std::end(values), T { 0 });
+    for (auto _ : state)
+    {
+        benchmark::ClobberMemory();
+        func(values.data(), std::size(values));
+        benchmark::DoNotOptimize(values);
+    }
+    state.SetBytesProcessed(
+        static_cast<int64_t>(state.iterations() * std::size(values) * sizeof(T)));
+}
+
+#define BYTE_SWAP_BENCHMARK(name, T, func)                                                         \
+    BENCHMARK_CAPTURE(BM_byte_swap, name, static_cast<void (*)(T* const, std::size_t)>(func))      \
+        ->RangeMultiplier(8)                                                                       \
+        ->Range(16, mega(16))                                                                      \
+        ->UseRealTime();
+
+BYTE_SWAP_BENCHMARK(uint16_scalar, uint16_t, scalar_byte_swap<uint16_t>)
+BYTE_SWAP_BENCHMARK(uint32_scalar, uint32_t, scalar_byte_swap<uint32_t>)
+BYTE_SWAP_BENCHMARK(uint64_scalar, uint64_t, scalar_byte_swap<uint64_t>)
+#ifndef CDFPP_NO_SIMD
+BYTE_SWAP_BENCHMARK(uint16_vectorized, uint16_t, vectorized_byte_swap)
+BYTE_SWAP_BENCHMARK(uint32_vectorized, uint32_t, vectorized_byte_swap)
+BYTE_SWAP_BENCHMARK(uint64_vectorized, uint64_t, vectorized_byte_swap)
+#endif
+BYTE_SWAP_BENCHMARK(uint16_entry_point, uint16_t, entry_point_byte_swap<uint16_t>)
+BYTE_SWAP_BENCHMARK(uint32_entry_point, uint32_t, entry_point_byte_swap<uint32_t>)
+BYTE_SWAP_BENCHMARK(uint64_entry_point, uint64_t, entry_point_byte_swap<uint64_t>)
+
+BENCHMARK_MAIN();
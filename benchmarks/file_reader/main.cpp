@@ -1,4 +1,5 @@
 #include <benchmark/benchmark.h>
+#include <cdfpp/cdf-io/loading/buffers.hpp>
 #include <cdfpp/no_init_vector.hpp>
 #include <cstring>
 #include <errno.h>
@@ -237,4 +238,58 @@ BENCHMARK(BM_raw_read<no_init_vector<char>>)
     ->Range(mega(4), mega(64))
     ->Complexity();
 
+#ifdef USE_MMAP
+/*
+ * Reads the file by chunks through the same buffers the loader uses, with and without
+ * read-ahead hints on the pread based one. Dropping the page cache before running makes
+ * the difference visible, on a warm cache both should be memcpy bound.
+ */
+template <bool use_pread, bool use_prefetch>
+static void BM_shared_buffer_chunked_read(benchmark::State& state)
+{
+    constexpr std::size_t chunk = 1024 * 1024;
+    constexpr std::size_t prefetch_window = 16;
+    auto test_file = make_test_file(state.range(0));
+    auto size = std::filesystem::file_size(test_file);
+    no_init_vector<char> data(size);
+    for (auto _ : state)
+    {
+        auto buffer = [&]()
+        {
+            if constexpr (use_pread)
+                return cdf::io::buffers::make_shared_pread_file_adapter(test_file);
+            else
+                return cdf::io::buffers::make_shared_file_adapter(test_file);
+        }();
+        if constexpr (use_prefetch)
+            buffer.prefetch(0UL, std::min(size, prefetch_window * chunk));
+        for (std::size_t offset = 0; offset < size; offset += chunk)
+        {
+            if constexpr (use_prefetch)
+                if (offset + prefetch_window * chunk < size)
+                    buffer.prefetch(offset + prefetch_window * chunk, chunk);
+            buffer.read(data.data() + offset, offset, std::min(chunk, size - offset));
+        }
+    }
+    state.counters["Bytes"] = size;
+    state.counters["Read Speed"] = benchmark::Counter(
+        size, benchmark::Counter::kIsIterationInvariantRate, benchmark::Counter::OneK::kIs1024);
+}
+BENCHMARK(BM_shared_buffer_chunked_read<false, false>)
+    ->Name("shared mmap_adapter 1M chunks")
+    ->RangeMultiplier(4)
+    ->Range(mega(4), mega(64))
+    ->Complexity();
+BENCHMARK(BM_shared_buffer_chunked_read<true, false>)
+    ->Name("shared pread_adapter 1M chunks")
+    ->RangeMultiplier(4)
+    ->Range(mega(4), mega(64))
+    ->Complexity();
+BENCHMARK(BM_shared_buffer_chunked_read<true, true>)
+    ->Name("shared pread_adapter 1M chunks with read-ahead")
+    ->RangeMultiplier(4)
+    ->Range(mega(4), mega(64))
+    ->Complexity();
+#endif
+
 BENCHMARK_MAIN();
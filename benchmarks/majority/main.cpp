@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+#include <cdfpp/cdf-io/majority-swap.hpp>
+#include <cdfpp/cdf-io/parallel.hpp>
+#include <cdfpp/no_init_vector.hpp>
+#include <numeric>
+
+inline constexpr std::size_t mega(std::size_t n)
+{
+    return n * 1024 * 1024;
+}
+
+/* record shapes like a_col_major_cdf.cdf small records and typical particle distributions */
+template <typename T>
+static void BM_majority_swap(benchmark::State& state, T, std::vector<uint32_t> record_shape)
+{
+    const auto record_size = std::accumulate(std::cbegin(record_shape), std::cend(record_shape),
+        1UL, std::multiplies<std::size_t>());
+    no_init_vector<uint32_t> shape(std::size(record_shape) + 1);
+    shape[0] = static_cast<uint32_t>(mega(64) / (record_size * sizeof(T)));
+    std::copy(std::cbegin(record_shape), std::cend(record_shape), std::begin(shape) + 1);
+    no_init_vector<T> values(shape[0] * record_size);
+    std::iota(std::begin(values), std::end(values), T { 0 });
+    cdf::io::parallel::set_max_threads(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        cdf::majority::swap<false>(values, shape);
+        benchmark::DoNotOptimize(values);
+    }
+    cdf::io::parallel::set_max_threads(1);
+    state.SetBytesProcessed(
+        static_cast<int64_t>(state.iterations() * std::size(values) * sizeof(T)));
+}
+
+BENCHMARK_CAPTURE(
+    BM_majority_swap, small_2d_records_double, double {}, std::vector<uint32_t> { 3, 5 })
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(
+    BM_majority_swap, distribution_2d_double, double {}, std::vector<uint32_t> { 32, 16 })
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(
+    BM_majority_swap, distribution_3d_float, float {}, std::vector<uint32_t> { 32, 16, 8 })
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(
+    BM_majority_swap, distribution_3d_double, double {}, std::vector<uint32_t> { 32, 16, 8 })
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(
+    BM_majority_swap, generic_4d_double, double {}, std::vector<uint32_t> { 8, 4, 4, 8 })
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include <cdfpp/cdf-io/cdf-io.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef DATA_PATH
+#define DATA_PATH "tests/resources"
+#endif
+
+std::vector<std::string> cdf_files()
+{
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator { DATA_PATH })
+    {
+        if (entry.path().extension() == ".cdf" and entry.path().filename() != "not_a_cdf.cdf")
+            files.push_back(entry.path().string());
+    }
+    return files;
+}
+
+/*
+ * Mimics a catalogue indexer, opens every file of tests/resources and reads variables names,
+ * types, shapes and a couple of ISTP attributes.
+ */
+template <bool metadata_only>
+static void BM_index_files(benchmark::State& state)
+{
+    const auto files = cdf_files();
+    std::size_t total = 0;
+    for (auto _ : state)
+    {
+        for (const auto& file : files)
+        {
+            auto cd = [&]()
+            {
+                if constexpr (metadata_only)
+                    return cdf::io::load_metadata(file);
+                else
+                    return cdf::io::load(file);
+            }();
+            if (cd)
+            {
+                for (const auto& [name, var] : cd->variables)
+                {
+                    total += std::size(name) + static_cast<std::size_t>(var.type())
+                        + std::size(var.shape());
+                    if (auto it = var.attributes.find("UNITS"); it != std::cend(var.attributes))
+                        total += it->second.value().bytes();
+                }
+                if (auto it = cd->attributes.find("Logical_source");
+                    it != std::cend(cd->attributes))
+                    total += std::size(it->second);
+            }
+        }
+    }
+    benchmark::DoNotOptimize(total);
+    state.counters["files/s"] = benchmark::Counter(static_cast<double>(std::size(files)),
+        benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_index_files<false>)->Name("Index files with load");
+BENCHMARK(BM_index_files<true>)->Name("Index files with load_metadata");
+
+BENCHMARK_MAIN();
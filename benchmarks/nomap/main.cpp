@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <cdfpp/nomap.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* ISTP like names, sharing long prefixes as variables and attributes of real files do */
+std::vector<std::string> make_keys(std::size_t count)
+{
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+        keys.push_back("mms1_fpi_brst_l2_des_energyspectr_" + std::to_string(i));
+    return keys;
+}
+
+template <typename map_t>
+static void BM_insert(benchmark::State& state)
+{
+    const auto keys = make_keys(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        map_t map;
+        for (std::size_t i = 0; i < std::size(keys); i++)
+            map[keys[i]] = i;
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename map_t>
+static void BM_lookup(benchmark::State& state)
+{
+    const auto keys = make_keys(static_cast<std::size_t>(state.range(0)));
+    map_t map;
+    for (std::size_t i = 0; i < std::size(keys); i++)
+        map[keys[i]] = i;
+    for (auto _ : state)
+    {
+        std::size_t total = 0;
+        for (const auto& key : keys)
+            total += map.at(key);
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename map_t>
+static void BM_compare(benchmark::State& state)
+{
+    const auto keys = make_keys(static_cast<std::size_t>(state.range(0)));
+    map_t map;
+    for (std::size_t i = 0; i < std::size(keys); i++)
+        map[keys[i]] = i;
+    const map_t other = map;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(map == other);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+using nomap_t = nomap<std::string, std::size_t>;
+using unordered_map_t = std::unordered_map<std::string, std::size_t>;
+
+BENCHMARK(BM_insert<nomap_t>)->Name("nomap insert")->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK(BM_insert<unordered_map_t>)
+    ->Name("unordered_map insert")
+    ->RangeMultiplier(10)
+    ->Range(10, 10000);
+BENCHMARK(BM_lookup<nomap_t>)->Name("nomap lookup")->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK(BM_lookup<unordered_map_t>)
+    ->Name("unordered_map lookup")
+    ->RangeMultiplier(10)
+    ->Range(10, 10000);
+BENCHMARK(BM_compare<nomap_t>)->Name("nomap compare")->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK(BM_compare<unordered_map_t>)
+    ->Name("unordered_map compare")
+    ->RangeMultiplier(10)
+    ->Range(10, 10000);
+
+BENCHMARK_MAIN();
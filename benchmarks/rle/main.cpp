@@ -4,33 +4,78 @@
 #include <cstring>
 #include <random>
 
-no_init_vector<char> make_rle_friendly_data(std::size_t size, double zero_fraction)
+enum class sparsity
+{
+    // independent bytes, half of them zero
+    random_half,
+    // little endian uint32 histogram counters, mostly empty bins and small counts
+    sparse_counters,
+    // doubles without exact zeros, RLE is useless but files still use it
+    dense_doubles,
+    // fill values or empty records
+    all_zeros
+};
+
+no_init_vector<char> make_rle_friendly_data(std::size_t size, sparsity profile)
 {
     no_init_vector<char> data(size);
     std::mt19937 rng(42);
     std::uniform_real_distribution<double> dist(0.0, 1.0);
-    std::uniform_int_distribution<int> byte_dist(1, 127);
-    for (auto& b : data)
-        b = (dist(rng) < zero_fraction) ? 0 : static_cast<char>(byte_dist(rng));
+    switch (profile)
+    {
+        case sparsity::random_half:
+        {
+            std::uniform_int_distribution<int> byte_dist(1, 127);
+            for (auto& b : data)
+                b = (dist(rng) < 0.5) ? 0 : static_cast<char>(byte_dist(rng));
+            break;
+        }
+        case sparsity::sparse_counters:
+        {
+            std::geometric_distribution<uint32_t> count_dist(0.05);
+            for (std::size_t i = 0; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t))
+            {
+                const uint32_t count = (dist(rng) < 0.9) ? 0U : count_dist(rng);
+                std::memcpy(data.data() + i, &count, sizeof(count));
+            }
+            std::memset(data.data() + size / sizeof(uint32_t) * sizeof(uint32_t), 0,
+                size % sizeof(uint32_t));
+            break;
+        }
+        case sparsity::dense_doubles:
+        {
+            for (std::size_t i = 0; i + sizeof(double) <= size; i += sizeof(double))
+            {
+                const double value = 1. + dist(rng);
+                std::memcpy(data.data() + i, &value, sizeof(value));
+            }
+            std::memset(data.data() + size / sizeof(double) * sizeof(double), 1,
+                size % sizeof(double));
+            break;
+        }
+        case sparsity::all_zeros:
+            std::memset(data.data(), 0, size);
+            break;
+    }
     return data;
 }
 
-static void BM_rle_deflate(benchmark::State& state)
+static void BM_rle_deflate(benchmark::State& state, sparsity profile)
 {
-    auto data = make_rle_friendly_data(state.range(0), 0.5);
+    auto data = make_rle_friendly_data(state.range(0), profile);
     for (auto _ : state)
     {
         auto result = cdf::io::rle::deflate(data);
         benchmark::DoNotOptimize(result);
     }
-    state.counters["bytes_per_second"]
-        = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::size(data)));
+    state.counters["ratio"] = static_cast<double>(std::size(cdf::io::rle::deflate(data)))
+        / static_cast<double>(std::size(data));
 }
-BENCHMARK(BM_rle_deflate)->RangeMultiplier(4)->Range(1024, 1024 * 1024)->Complexity();
 
-static void BM_rle_inflate(benchmark::State& state)
+static void BM_rle_inflate(benchmark::State& state, sparsity profile)
 {
-    auto data = make_rle_friendly_data(state.range(0), 0.5);
+    auto data = make_rle_friendly_data(state.range(0), profile);
     auto compressed = cdf::io::rle::deflate(data);
     no_init_vector<char> output(data.size());
     for (auto _ : state)
@@ -38,14 +83,12 @@ static void BM_rle_inflate(benchmark::State& state)
         cdf::io::rle::inflate(compressed, output.data(), output.size());
         benchmark::DoNotOptimize(output);
     }
-    state.counters["bytes_per_second"]
-        = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::size(data)));
 }
-BENCHMARK(BM_rle_inflate)->RangeMultiplier(4)->Range(1024, 1024 * 1024)->Complexity();
 
-static void BM_rle_roundtrip(benchmark::State& state)
+static void BM_rle_roundtrip(benchmark::State& state, sparsity profile)
 {
-    auto data = make_rle_friendly_data(state.range(0), 0.5);
+    auto data = make_rle_friendly_data(state.range(0), profile);
     no_init_vector<char> output(data.size());
     for (auto _ : state)
     {
@@ -53,9 +96,25 @@ static void BM_rle_roundtrip(benchmark::State& state)
         cdf::io::rle::inflate(compressed, output.data(), output.size());
         benchmark::DoNotOptimize(output);
     }
-    state.counters["bytes_per_second"]
-        = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::size(data)));
 }
-BENCHMARK(BM_rle_roundtrip)->RangeMultiplier(4)->Range(1024, 1024 * 1024)->Complexity();
+
+#define RLE_BENCHMARKS(bench)                                                                      \
+    BENCHMARK_CAPTURE(bench, random_half, sparsity::random_half)                                  \
+        ->RangeMultiplier(4)                                                                       \
+        ->Range(1024, 1024 * 1024);                                                                \
+    BENCHMARK_CAPTURE(bench, sparse_counters, sparsity::sparse_counters)                          \
+        ->RangeMultiplier(4)                                                                       \
+        ->Range(1024, 1024 * 1024);                                                                \
+    BENCHMARK_CAPTURE(bench, dense_doubles, sparsity::dense_doubles)                              \
+        ->RangeMultiplier(4)                                                                       \
+        ->Range(1024, 1024 * 1024);                                                                \
+    BENCHMARK_CAPTURE(bench, all_zeros, sparsity::all_zeros)                                      \
+        ->RangeMultiplier(4)                                                                       \
+        ->Range(1024, 1024 * 1024);
+
+RLE_BENCHMARKS(BM_rle_deflate)
+RLE_BENCHMARKS(BM_rle_inflate)
+RLE_BENCHMARKS(BM_rle_roundtrip)
 
 BENCHMARK_MAIN();
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+#include <cdfpp/cdf-io/cdf-io.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef DATA_PATH
+#define DATA_PATH "tests/resources"
+#endif
+
+std::vector<std::string> cdf_files()
+{
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator { DATA_PATH })
+    {
+        if (entry.path().extension() == ".cdf" and entry.path().filename() != "not_a_cdf.cdf")
+            files.push_back(entry.path().string());
+    }
+    return files;
+}
+
+/* ISTP like attribute text, with one latin1 degree sign every latin1_every bytes when not 0 */
+std::string make_text(std::size_t size, std::size_t latin1_every)
+{
+    const std::string words = "Magnetic field vector in GSE coordinates, 3 s averages ";
+    std::string text;
+    text.reserve(size);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        if (latin1_every != 0 and i % latin1_every == latin1_every - 1)
+            text.push_back(static_cast<char>(0xb0));
+        else
+            text.push_back(words[i % std::size(words)]);
+    }
+    return text;
+}
+
+static void BM_is_valid_utf8(benchmark::State& state)
+{
+    const auto text = make_text(static_cast<std::size_t>(state.range(0)), 0);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cdf::is_valid_utf8(text.data(), std::size(text)));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::size(text)));
+}
+BENCHMARK(BM_is_valid_utf8)->Arg(16)->Arg(64)->Arg(256)->Arg(4096)->Arg(1 << 20);
+
+static void BM_iso_8859_1_to_utf8(benchmark::State& state)
+{
+    const auto text = make_text(static_cast<std::size_t>(state.range(0)), 80);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(
+            cdf::ensure_utf8<no_init_vector<char>>(text.data(), std::size(text)));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::size(text)));
+}
+BENCHMARK(BM_iso_8859_1_to_utf8)->Arg(16)->Arg(64)->Arg(256)->Arg(4096)->Arg(1 << 20);
+
+/* every attribute and CHAR variable goes through ensure_utf8 when iso_8859_1_to_utf8 is set */
+template <bool iso_8859_1_to_utf8>
+static void BM_load_files(benchmark::State& state)
+{
+    const auto files = cdf_files();
+    for (auto _ : state)
+    {
+        for (const auto& file : files)
+            benchmark::DoNotOptimize(cdf::io::load(file, iso_8859_1_to_utf8, false));
+    }
+    state.counters["files/s"] = benchmark::Counter(static_cast<double>(std::size(files)),
+        benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_load_files<false>)->Name("Load files as is");
+BENCHMARK(BM_load_files<true>)->Name("Load files with iso_8859_1_to_utf8");
+
+BENCHMARK_MAIN();
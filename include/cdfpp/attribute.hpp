@@ -26,12 +26,55 @@
 #pragma once
 #include "cdf-data.hpp"
 #include "cdf-repr.hpp"
+#include <atomic>
+#include <functional>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <variant>
 
 namespace cdf
 {
+
+namespace _details
+{
+    /*
+     * Values decoded on first access, shared by all copies of an attribute so they are decoded
+     * at most once even when several threads read them concurrently. A loader failure is
+     * reported to the caller and the next access tries again.
+     */
+    template <typename T, typename loader_t>
+    struct lazy_values_t
+    {
+        explicit lazy_values_t(loader_t&& loader) : loader { std::move(loader) } { }
+
+        [[nodiscard]] const T& get()
+        {
+            std::call_once(loaded,
+                [this]()
+                {
+                    if constexpr (requires(loader_t & l) { l.load(); })
+                        values = loader.load();
+                    else
+                        values = loader();
+                    done = true;
+                });
+            return values;
+        }
+
+        loader_t loader;
+        std::once_flag loaded;
+        std::atomic<bool> done { false };
+        T values;
+    };
+}
+
+/*
+ * Lazily loaded attributes values are decoded on first access, const accesses from several
+ * threads are safe, mutable accesses give the attribute its own copy of the values and must
+ * not run concurrently with any other access.
+ */
 struct Attribute
 {
     using attr_data_t = std::vector<data_t>;
@@ -46,6 +89,7 @@ struct Attribute
     using const_pointer = attr_data_t::const_pointer;
     using reverse_iterator = attr_data_t::reverse_iterator;
     using const_reverse_iterator = attr_data_t::const_reverse_iterator;
+    using loader_t = std::function<attr_data_t()>;
 
 
     std::string name;
@@ -63,66 +107,82 @@ struct Attribute
         this->data = std::move(data);
     }
 
+    /*
+     * Values are only decoded by loader on first access, used when loading files metadata
+     * only.
+     */
+    Attribute(const std::string& name, loader_t&& loader) : name { name }
+    {
+        if (name.empty())
+        {
+            throw std::invalid_argument { "Attribute name cannot be empty" };
+        }
+        this->p_lazy = std::make_shared<lazy_values_t>(std::move(loader));
+    }
+
     inline bool operator==(const Attribute& other) const
     {
-        return other.name == name && other.data == data;
+        return other.name == name && other._data() == _data();
     }
 
     template <CDF_Types type>
     [[nodiscard]] inline decltype(auto) get(std::size_t index)
     {
-        return data[index].get<type>();
+        return _data()[index].get<type>();
     }
 
     template <CDF_Types type>
     [[nodiscard]] inline decltype(auto) get(std::size_t index) const
     {
-        return data[index].get<type>();
+        return _data()[index].get<type>();
     }
 
     template <typename type>
     [[nodiscard]] inline decltype(auto) get(std::size_t index)
     {
-        return data[index].get<type>();
+        return _data()[index].get<type>();
     }
 
     template <typename type>
     [[nodiscard]] inline decltype(auto) get(std::size_t index) const
     {
-        return data[index].get<type>();
+        return _data()[index].get<type>();
     }
 
-    inline void swap(attr_data_t& new_data) { std::swap(data, new_data); }
+    inline void swap(attr_data_t& new_data) { std::swap(_data(), new_data); }
 
     inline Attribute& operator=(attr_data_t& new_data)
     {
+        p_lazy = nullptr;
         data = new_data;
         return *this;
     }
 
     inline Attribute& operator=(attr_data_t&& new_data)
     {
+        p_lazy = nullptr;
         data = std::move(new_data);
         return *this;
     }
 
     inline void set_data(const Attribute& other)
     {
-        data = other.data;
+        data = other._data();
+        p_lazy = nullptr;
     }
 
-    [[nodiscard]] inline std::size_t size() const noexcept { return std::size(data); }
-    [[nodiscard]] inline data_t& operator[](std::size_t index) { return data[index]; }
-    [[nodiscard]] inline const data_t& operator[](std::size_t index) const { return data[index]; }
+    [[nodiscard]] inline std::size_t size() const { return std::size(_data()); }
+    [[nodiscard]] inline data_t& operator[](std::size_t index) { return _data()[index]; }
+    [[nodiscard]] inline const data_t& operator[](std::size_t index) const { return _data()[index]; }
 
-    inline void push_back(const data_t& value) { data.push_back(value); }
+    inline void push_back(const data_t& value) { _data().push_back(value); }
 
-    inline void push_back(data_t&& value) { data.push_back(std::move(value)); }
+    inline void push_back(data_t&& value) { _data().push_back(std::move(value)); }
 
     template <class... Args>
     auto emplace_back(Args&&... args)
     {
-        return data.emplace_back(std::forward<Args>(args)...);
+        return _data().emplace_back(std::forward<Args>(args)...);
     }
 
     template <typename... Ts>
@@ -131,20 +191,20 @@ struct Attribute
     template <typename... Ts>
     friend void visit(const Attribute& attr, Ts... lambdas);
 
-    [[nodiscard]] inline auto begin() { return data.begin(); }
-    [[nodiscard]] inline auto end() { return data.end(); }
+    [[nodiscard]] inline auto begin() { return _data().begin(); }
+    [[nodiscard]] inline auto end() { return _data().end(); }
 
-    [[nodiscard]] inline auto begin() const { return data.begin(); }
-    [[nodiscard]] inline auto end() const { return data.end(); }
+    [[nodiscard]] inline auto begin() const { return _data().begin(); }
+    [[nodiscard]] inline auto end() const { return _data().end(); }
 
-    [[nodiscard]] inline auto cbegin() const { return data.cbegin(); }
-    [[nodiscard]] inline auto cend() const { return data.cend(); }
+    [[nodiscard]] inline auto cbegin() const { return _data().cbegin(); }
+    [[nodiscard]] inline auto cend() const { return _data().cend(); }
 
-    [[nodiscard]] inline data_t& back() { return data.back(); }
-    [[nodiscard]] inline const data_t& back() const { return data.back(); }
+    [[nodiscard]] inline data_t& back() { return _data().back(); }
+    [[nodiscard]] inline const data_t& back() const { return _data().back(); }
 
-    [[nodiscard]] inline data_t& front() { return data.front(); }
-    [[nodiscard]] inline const data_t& front() const { return data.front(); }
+    [[nodiscard]] inline data_t& front() { return _data().front(); }
+    [[nodiscard]] inline const data_t& front() const { return _data().front(); }
 
     template <class stream_t>
     inline stream_t& __repr__(stream_t& os, indent_t indent = {}) const
@@ -164,8 +224,37 @@ struct Attribute
         return os;
     }
 
+    [[nodiscard]] inline bool values_loaded() const noexcept
+    {
+        return not p_lazy or p_lazy->done;
+    }
+
 private:
+    using lazy_values_t = _details::lazy_values_t<attr_data_t, loader_t>;
+
+    inline attr_data_t& _data()
+    {
+        if (p_lazy)
+        {
+            const auto& values = p_lazy->get();
+            if (p_lazy.use_count() == 1)
+                data = std::move(p_lazy->values);
+            else
+                data = values;
+            p_lazy = nullptr;
+        }
+        return data;
+    }
+
+    inline const attr_data_t& _data() const
+    {
+        if (p_lazy)
+            return p_lazy->get();
+        return data;
+    }
+
     attr_data_t data;
+    std::shared_ptr<lazy_values_t> p_lazy;
 };
 
 struct VariableAttribute
@@ -186,61 +275,79 @@ struct VariableAttribute
         this->data = std::move(data);
     }
 
+    /* values are only decoded on first access, see Attribute */
+    VariableAttribute(const std::string& name, lazy_data&& data) : name { name }
+    {
+        if (name.empty())
+        {
+            throw std::invalid_argument { "Attribute name cannot be empty" };
+        }
+        this->p_lazy = std::make_shared<lazy_values_t>(std::move(data));
+    }
+
     inline bool operator==(const VariableAttribute& other) const
     {
-        return other.name == name && other.data == data;
+        return other.name == name && other._data() == _data();
     }
 
-    inline CDF_Types type() const noexcept { return data.type(); }
+    inline CDF_Types type() const noexcept
+    {
+        if (p_lazy)
+            return p_lazy->loader.type();
+        return data.type();
+    }
 
     template <CDF_Types type>
     [[nodiscard]] inline decltype(auto) get()
     {
-        return data.get<type>();
+        return _data().get<type>();
     }
 
     template <CDF_Types type>
     [[nodiscard]] inline decltype(auto) get() const
     {
-        return data.get<type>();
+        return _data().get<type>();
     }
 
     template <typename type>
     [[nodiscard]] inline decltype(auto) get()
     {
-        return data.get<type>();
+        return _data().get<type>();
     }
 
     template <typename type>
     [[nodiscard]] inline decltype(auto) get() const
     {
-        return data.get<type>();
+        return _data().get<type>();
     }
 
-    inline void swap(data_t& new_data) { std::swap(data, new_data); }
+    inline void swap(data_t& new_data) { std::swap(_data(), new_data); }
 
     inline VariableAttribute& operator=(attr_data_t& new_data)
     {
+        p_lazy = nullptr;
         data = new_data;
         return *this;
     }
 
     inline VariableAttribute& operator=(attr_data_t&& new_data)
     {
+        p_lazy = nullptr;
         data = std::move(new_data);
         return *this;
     }
 
     inline void set_data(const VariableAttribute& other)
     {
-        data = other.data;
+        data = other._data();
+        p_lazy = nullptr;
     }
 
-    inline data_t& operator*() { return data; }
-    inline const data_t& operator*() const { return data; }
+    inline data_t& operator*() { return _data(); }
+    inline const data_t& operator*() const { return _data(); }
 
-    [[nodiscard]] inline data_t& value() { return data; }
-    [[nodiscard]] inline const data_t& value() const { return data; }
+    [[nodiscard]] inline data_t& value() { return _data(); }
+    [[nodiscard]] inline const data_t& value() const { return _data(); }
 
     template <typename... Ts>
     friend void visit(Attribute& attr, Ts... lambdas);
@@ -251,25 +358,54 @@ struct VariableAttribute
     template <class stream_t>
     inline stream_t& __repr__(stream_t& os, indent_t indent = {}) const
     {
-        os << indent << name << ": " << data << std::endl;
+        os << indent << name << ": " << _data() << std::endl;
         return os;
     }
 
+    [[nodiscard]] inline bool values_loaded() const noexcept
+    {
+        return not p_lazy or p_lazy->done;
+    }
+
 private:
+    using lazy_values_t = _details::lazy_values_t<data_t, lazy_data>;
+
+    inline data_t& _data()
+    {
+        if (p_lazy)
+        {
+            const auto& values = p_lazy->get();
+            if (p_lazy.use_count() == 1)
+                data = std::move(p_lazy->values);
+            else
+                data = values;
+            p_lazy = nullptr;
+        }
+        return data;
+    }
+
+    inline const data_t& _data() const
+    {
+        if (p_lazy)
+            return p_lazy->get();
+        return data;
+    }
+
     data_t data;
+    std::shared_ptr<lazy_values_t> p_lazy;
 };
 
 template <typename... Ts>
 void visit(Attribute& attr, Ts... lambdas)
 {
-    std::for_each(std::cbegin(attr.data), std::cend(attr.data),
+    std::for_each(std::cbegin(attr), std::cend(attr),
         [lambdas...](const auto& element) { visit(element, lambdas...); });
 }
 
 template <typename... Ts>
 void visit(const Attribute& attr, Ts... lambdas)
 {
-    std::for_each(std::cbegin(attr.data), std::cend(attr.data),
+    std::for_each(std::cbegin(attr), std::cend(attr),
         [lambdas...](const auto& element) { visit(element, lambdas...); });
 }
 } // namespace cdf
@@ -30,13 +30,20 @@
 #include "cdf-io/endianness.hpp"
 #include "no_init_vector.hpp"
 #include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <stdint.h>
 #include <string>
 #include <variant>
 #include <vector>
 
+#ifndef CDFPP_NO_SIMD
+#include "vectorized/utf8.hpp"
+#endif
+
 namespace cdf
 {
 
@@ -75,14 +82,32 @@ struct data_t
 
     [[nodiscard]] CDF_Types type() const noexcept { return p_type; }
 
-    [[nodiscard]] cdf_values_t& values() noexcept { return p_values; }
-    [[nodiscard]] const cdf_values_t& values() const noexcept { return p_values; }
+    [[nodiscard]] cdf_values_t& values()
+    {
+        materialize();
+        return p_values;
+    }
+    [[nodiscard]] const cdf_values_t& values() const
+    {
+        materialize();
+        return p_values;
+    }
+
+    /*
+     * Mapped values are read directly from memory owned by someone else (usually a memory
+     * mapped file kept alive by p_owner). They are copied into a vector on the first mutable
+     * access, const byte access (bytes_ptr() const, size(), bytes()) never copies.
+     */
+    [[nodiscard]] bool is_mapped() const noexcept { return p_mapped != nullptr; }
 
     data_t& operator=(data_t&& other);
     data_t& operator=(const data_t& other);
 
     inline bool operator==(const data_t& other) const
     {
+        if (is_mapped() or other.is_mapped())
+            return other.p_type == p_type && other.bytes() == bytes()
+                && (bytes() == 0 || std::memcmp(other.bytes_ptr(), bytes_ptr(), bytes()) == 0);
         return other.p_type == p_type && other.p_values == p_values;
     }
 
@@ -104,6 +129,16 @@ struct data_t
     {
     }
 
+    data_t(std::shared_ptr<const void>&& owner, const char* values, std::size_t bytes,
+        CDF_Types type)
+            : p_values { cdf_none {} }
+            , p_type { type }
+            , p_owner { std::move(owner) }
+            , p_mapped { values }
+            , p_mapped_bytes { bytes }
+    {
+    }
+
     template <typename... Ts>
     friend auto visit(data_t& data, Ts... lambdas);
     template <typename... Ts>
@@ -113,17 +148,41 @@ struct data_t
     friend decltype(auto) _get_impl(T* self);
 
 private:
-    cdf_values_t p_values;
+    void materialize() const;
+
+    mutable cdf_values_t p_values;
     CDF_Types p_type;
+    mutable std::shared_ptr<const void> p_owner;
+    mutable const char* p_mapped = nullptr;
+    mutable std::size_t p_mapped_bytes = 0UL;
 };
 
 struct lazy_data
 {
+    using records_loader_t = std::function<data_t(std::size_t, std::size_t)>;
+    /* decodes records [first, last) into dest, returns false when it can't (see load_records_into) */
+    using records_into_loader_t = std::function<bool(char*, std::size_t, std::size_t)>;
     lazy_data() = default;
     lazy_data(std::function<data_t(void)>&& loader, CDF_Types type)
             : p_loader { std::move(loader) }, p_type { type }
     {
     }
+    lazy_data(std::function<data_t(void)>&& loader, records_loader_t&& records_loader,
+        CDF_Types type)
+            : p_loader { std::move(loader) }
+            , p_records_loader { std::move(records_loader) }
+            , p_type { type }
+    {
+    }
+    lazy_data(std::function<data_t(void)>&& loader, records_loader_t&& records_loader,
+        records_into_loader_t&& records_into_loader, CDF_Types type, bool values_row_major = false)
+            : p_loader { std::move(loader) }
+            , p_records_loader { std::move(records_loader) }
+            , p_records_into_loader { std::move(records_into_loader) }
+            , p_type { type }
+            , p_values_row_major { values_row_major }
+    {
+    }
     lazy_data(const lazy_data&) = default;
     lazy_data(lazy_data&&) = default;
     lazy_data& operator=(const lazy_data&) = default;
@@ -131,22 +190,54 @@ struct lazy_data
 
     [[nodiscard]] inline data_t load() { return p_loader(); }
 
+    /* loads records [first, last) only, data is returned with file majority */
+    [[nodiscard]] inline data_t load_records(std::size_t first, std::size_t last) const
+    {
+        return p_records_loader(first, last);
+    }
+
+    [[nodiscard]] inline bool can_load_records() const noexcept
+    {
+        return static_cast<bool>(p_records_loader);
+    }
+
+    /*
+     * Decodes records [first, last) straight into dest, with file majority, dest must be
+     * large enough. Returns false when values need a conversion that changes their size
+     * (latin1 to utf8), the caller has to load them instead.
+     */
+    [[nodiscard]] inline bool load_records_into(char* dest, std::size_t first, std::size_t last) const
+    {
+        return p_records_into_loader and p_records_into_loader(dest, first, last);
+    }
+
     [[nodiscard]] inline CDF_Types type() const noexcept { return p_type; }
 
+    /*
+     * true when load() returns values already transposed to row major, the loader did it
+     * while decoding (see block_decoder_t), records loaders still use file majority.
+     */
+    [[nodiscard]] inline bool values_row_major() const noexcept { return p_values_row_major; }
+
 private:
     std::function<data_t(void)> p_loader;
+    records_loader_t p_records_loader;
+    records_into_loader_t p_records_into_loader;
     CDF_Types p_type;
+    bool p_values_row_major = false;
 };
 
 template <typename... Ts>
 auto visit(data_t& data, Ts... lambdas)
 {
+    data.materialize();
     return std::visit(helpers::Visitor { lambdas... }, data.p_values);
 }
 
 template <typename... Ts>
 auto visit(const data_t& data, Ts... lambdas)
 {
+    data.materialize();
     return std::visit(helpers::Visitor { lambdas... }, data.p_values);
 }
 
@@ -164,12 +255,14 @@ data_t load_values(data_t& data, cdf_encoding encoding);
 template <CDF_Types _type>
 inline decltype(auto) data_t::get()
 {
+    materialize();
     return std::get<no_init_vector<from_cdf_type_t<_type>>>(this->p_values);
 }
 
 template <CDF_Types _type>
 inline decltype(auto) data_t::get() const
 {
+    materialize();
     return std::get<no_init_vector<from_cdf_type_t<_type>>>(this->p_values);
 }
 
@@ -177,6 +270,7 @@ inline decltype(auto) data_t::get() const
 template <typename T, typename _type>
 decltype(auto) _get_impl(T* self)
 {
+    self->materialize();
     return std::get<no_init_vector<_type>>(self->p_values);
 }
 
@@ -197,12 +291,18 @@ inline data_t& data_t::operator=(data_t&& other)
 {
     std::swap(this->p_values, other.p_values);
     std::swap(this->p_type, other.p_type);
+    std::swap(this->p_owner, other.p_owner);
+    std::swap(this->p_mapped, other.p_mapped);
+    std::swap(this->p_mapped_bytes, other.p_mapped_bytes);
     return *this;
 }
 inline data_t& data_t::operator=(const data_t& other)
 {
     this->p_values = other.p_values;
     this->p_type = other.p_type;
+    this->p_owner = other.p_owner;
+    this->p_mapped = other.p_mapped;
+    this->p_mapped_bytes = other.p_mapped_bytes;
     return *this;
 }
 
@@ -236,37 +336,109 @@ inline data_t& data_t::operator=(const data_t& other)
     return std::tuple{ state, codep };
 }
 
-// switch to SIMD later together with XSIMD integration
-[[nodiscard]] inline bool is_valid_utf8(const char* buffer, std::size_t buffer_size)
+namespace _details
 {
-    uint32_t state = 0;
-    uint32_t codepoint = 0;
-    for (std::size_t i = 0; i < buffer_size; ++i)
+    /* true when the 8 bytes at buffer are ASCII */
+    [[nodiscard]] inline bool is_ascii_word(const char* buffer)
     {
-        std::tie(state, codepoint) = decode(state, codepoint, static_cast<uint8_t>(buffer[i]));
+        uint64_t word;
+        std::memcpy(&word, buffer, sizeof(word));
+        return (word & 0x8080808080808080ULL) == 0;
     }
-    return state == 0;
-}
 
-// https://stackoverflow.com/questions/4059775/convert-iso-8859-1-strings-to-utf-8-in-c-c
-template <typename T>
-[[nodiscard]] T iso_8859_1_to_utf8(const char* buffer, std::size_t buffer_size)
-{
-    T out;
-    out.reserve(buffer_size);
-    std::for_each(buffer, buffer + buffer_size,
-        [&out](const uint8_t c)
+    /* ASCII runs are skipped 8 bytes at a time, the DFA only runs on multi-bytes sequences */
+    [[nodiscard]] inline bool scalar_is_valid_utf8(const char* buffer, std::size_t buffer_size)
+    {
+        uint32_t state = 0;
+        uint32_t codepoint = 0;
+        std::size_t i = 0;
+        while (i < buffer_size)
+        {
+            if (state == 0)
+            {
+                while (i + 8 <= buffer_size and is_ascii_word(buffer + i))
+                    i += 8;
+                if (i == buffer_size)
+                    break;
+            }
+            std::tie(state, codepoint)
+                = decode(state, codepoint, static_cast<uint8_t>(buffer[i++]));
+            // rejecting state, it never leaves it
+            if (state == 1)
+                return false;
+        }
+        return state == 0;
+    }
+
+    /* each latin1 byte above 0x7f takes two bytes in utf8 */
+    [[nodiscard]] inline std::size_t scalar_latin1_utf8_size(
+        const char* buffer, std::size_t buffer_size)
+    {
+        std::size_t size = buffer_size;
+        std::size_t i = 0;
+        for (; i + 8 <= buffer_size; i += 8)
         {
+            uint64_t word;
+            std::memcpy(&word, buffer + i, sizeof(word));
+            size += static_cast<std::size_t>(std::popcount(word & 0x8080808080808080ULL));
+        }
+        for (; i < buffer_size; i++)
+            size += static_cast<uint8_t>(buffer[i]) >> 7;
+        return size;
+    }
+
+    /* out must hold scalar_latin1_utf8_size(buffer, buffer_size) bytes */
+    inline void scalar_latin1_to_utf8(const char* buffer, std::size_t buffer_size, char* out)
+    {
+        std::size_t i = 0;
+        while (i < buffer_size)
+        {
+            if (i + 8 <= buffer_size and is_ascii_word(buffer + i))
+            {
+                std::memcpy(out, buffer + i, 8);
+                out += 8;
+                i += 8;
+                continue;
+            }
+            const uint8_t c = static_cast<uint8_t>(buffer[i++]);
             if (c < 0x80)
             {
-                out.push_back(c);
+                *out++ = static_cast<char>(c);
             }
             else
             {
-                out.push_back(0xc0 | c >> 6);
-                out.push_back(0x80 | (c & 0x3f));
+                *out++ = static_cast<char>(0xc0 | c >> 6);
+                *out++ = static_cast<char>(0x80 | (c & 0x3f));
             }
-        });
+        }
+    }
+}
+
+[[nodiscard]] inline bool is_valid_utf8(const char* buffer, std::size_t buffer_size)
+{
+#ifndef CDFPP_NO_SIMD
+    /* most attributes are a few bytes long, the dispatch overhead isn't worth it for them */
+    if (buffer_size >= 64)
+        return vectorized_is_valid_utf8(buffer, buffer_size);
+#endif
+    return _details::scalar_is_valid_utf8(buffer, buffer_size);
+}
+
+// https://stackoverflow.com/questions/4059775/convert-iso-8859-1-strings-to-utf-8-in-c-c
+template <typename T>
+[[nodiscard]] T iso_8859_1_to_utf8(const char* buffer, std::size_t buffer_size)
+{
+    T out;
+#ifndef CDFPP_NO_SIMD
+    if (buffer_size >= 64)
+    {
+        out.resize(vectorized_latin1_utf8_size(buffer, buffer_size));
+        vectorized_latin1_to_utf8(buffer, buffer_size, reinterpret_cast<char*>(std::data(out)));
+        return out;
+    }
+#endif
+    out.resize(_details::scalar_latin1_utf8_size(buffer, buffer_size));
+    _details::scalar_latin1_to_utf8(buffer, buffer_size, reinterpret_cast<char*>(std::data(out)));
     return out;
 }
 
@@ -305,9 +477,14 @@ template <CDF_Types _type, typename endianness_t, bool latin1_to_utf8_conv>
     }
     else
     {
-        if (std::size(data) != 0UL)
-            endianness::decode_v<endianness_t>(
-                reinterpret_cast<from_cdf_type_t<_type>*>(data.bytes_ptr()), data.size());
+        // decoding is skipped when there is nothing to swap to keep mapped values mapped
+        if constexpr (sizeof(from_cdf_type_t<_type>) > 1
+            and not std::is_same_v<endianness_t, endianness::host_endianness_t>)
+        {
+            if (std::size(data) != 0UL)
+                endianness::decode_v<endianness_t>(
+                    reinterpret_cast<from_cdf_type_t<_type>*>(data.bytes_ptr()), data.size());
+        }
         return std::move(data);
     }
 }
@@ -328,6 +505,44 @@ template <bool iso_8859_1_to_utf8>
         });
 }
 
+/*
+ * Same as load_values for values decoded in place into a caller provided buffer, returns false
+ * for strings that need a latin1 to utf8 conversion since it may change their size.
+ */
+template <bool iso_8859_1_to_utf8>
+[[nodiscard]] inline bool load_values(
+    char* values, std::size_t bytes, CDF_Types type, cdf_encoding encoding) noexcept
+{
+    if (type == CDF_Types::CDF_NONE)
+        return true;
+    return cdf_type_dispatch(type,
+        [&]<CDF_Types t>()
+        {
+            using value_t = from_cdf_type_t<t>;
+            if constexpr (t == CDF_Types::CDF_CHAR || t == CDF_Types::CDF_UCHAR)
+                return not iso_8859_1_to_utf8;
+            else if constexpr (sizeof(value_t) > 1)
+            {
+                if (bytes == 0)
+                    return true;
+                if (endianness::is_big_endian_encoding(encoding))
+                {
+                    if constexpr (not std::is_same_v<endianness::big_endian_t,
+                                      endianness::host_endianness_t>)
+                        endianness::decode_v<endianness::big_endian_t>(
+                            reinterpret_cast<value_t*>(values), bytes / sizeof(value_t));
+                }
+                else if constexpr (not std::is_same_v<endianness::little_endian_t,
+                                       endianness::host_endianness_t>)
+                    endianness::decode_v<endianness::little_endian_t>(
+                        reinterpret_cast<value_t*>(values), bytes / sizeof(value_t));
+                return true;
+            }
+            else
+                return true;
+        });
+}
+
 template <CDF_Types _type>
 [[nodiscard]] cdf_values_t new_cdf_values_container(std::size_t len)
 {
@@ -347,8 +562,23 @@ template <CDF_Types _type>
 }
 
 
+inline void data_t::materialize() const
+{
+    if (p_mapped != nullptr)
+    {
+        auto values = new_data_container(p_mapped_bytes, p_type);
+        std::memcpy(values.bytes_ptr(), p_mapped, p_mapped_bytes);
+        p_values = std::move(values.p_values);
+        p_mapped = nullptr;
+        p_mapped_bytes = 0UL;
+        p_owner.reset();
+    }
+}
+
 inline const char* data_t::bytes_ptr() const
 {
+    if (p_mapped != nullptr)
+        return p_mapped;
     return std::visit(
         [](const auto& v) -> const char*
         {
@@ -362,6 +592,7 @@ inline const char* data_t::bytes_ptr() const
 
 inline char* data_t::bytes_ptr()
 {
+    materialize();
     return std::visit(
         [](auto& v) -> char*
         {
@@ -375,6 +606,8 @@ inline char* data_t::bytes_ptr()
 
 inline std::size_t data_t::size() const noexcept
 {
+    if (p_mapped != nullptr)
+        return p_mapped_bytes / cdf_type_size(p_type);
     return std::visit(
         [](const auto& v) -> std::size_t
         {
@@ -388,6 +621,8 @@ inline std::size_t data_t::size() const noexcept
 
 inline std::size_t data_t::bytes() const noexcept
 {
+    if (p_mapped != nullptr)
+        return p_mapped_bytes;
     return std::visit(
         [](const auto& v) -> std::size_t
         {
@@ -25,4 +25,5 @@
 ----------------------------------------------------------------------------*/
 #pragma once
 #include "loading/loading.hpp"
+#include "saving/appending.hpp"
 #include "saving/saving.hpp"
@@ -40,6 +40,31 @@ namespace cdf::io::common
 using magic_numbers_t = std::pair<uint32_t, uint32_t>;
 using version_t = std::pair<uint8_t, uint8_t>;
 
+/* returns true for the names of the variables to load, an empty selector loads them all */
+using variable_selector = std::function<bool(const std::string&)>;
+
+/*
+ * A VVR or CVVR referenced by a VXR entry, holding records [first, last].
+ * offset and size locate the block payload (raw or compressed values) in the file.
+ */
+struct var_block_t
+{
+    std::size_t first;
+    std::size_t last;
+    std::size_t offset;
+    std::size_t size;
+    bool compressed;
+
+    [[nodiscard]] inline std::size_t records_count() const noexcept { return last - first + 1UL; }
+};
+
+/* what is needed to read variables values once headers are parsed, see header-cache.hpp */
+struct file_layout_t
+{
+    cdf_encoding encoding;
+    cdf_map<std::string, std::vector<var_block_t>> var_blocks;
+};
+
 struct iso_8859_1_to_utf8_t
 {
 };
@@ -117,6 +142,11 @@ struct cdf_repr
     cdf_majority majority;
     cdf_compression_type compression_type;
     bool lazy;
+    variable_selector selector;
+    /* per variable number, whether it was selected, empty when all variables are loaded */
+    std::vector<bool> selected_variables;
+    /* when set, filled with lazy variables block index while parsing */
+    file_layout_t* layout = nullptr;
     cdf_repr(std::size_t var_count) : var_attributes(var_count) { }
     cdf_repr(cdf_repr&&) = default;
     cdf_repr(const cdf_repr&) = delete;
@@ -124,6 +154,18 @@ struct cdf_repr
     cdf_repr& operator=(cdf_repr&&) = default;
 };
 
+[[nodiscard]] inline bool is_selected(const cdf_repr& repr, std::size_t variable_number)
+{
+    return std::empty(repr.selected_variables)
+        or (variable_number < std::size(repr.selected_variables)
+            and repr.selected_variables[variable_number]);
+}
+
+[[nodiscard]] inline bool is_selected(const cdf_repr& repr, const std::string& variable_name)
+{
+    return not repr.selector or repr.selector(variable_name);
+}
+
 void add_global_attribute(cdf_repr& repr, const std::string& name, Attribute::attr_data_t&& data)
 {
     repr.attributes[name] = Attribute { name, std::move(data) };
@@ -169,6 +211,14 @@ void add_variable(cdf_repr& repr, const std::string& name, std::size_t number,
     { return std::move(repr.var_attributes[number]); }();
 }
 
+void add_variable(cdf_repr& repr, Variable&& variable)
+{
+    const auto number = variable.number();
+    const auto name = variable.name();
+    auto& var = repr.variables[name] = std::move(variable);
+    var.attributes = std::move(repr.var_attributes[number]);
+}
+
 void add_lazy_variable(cdf_repr& repr, const std::string& name, std::size_t number,
     lazy_data&& data, Variable::shape_t&& shape, bool is_nrv, cdf_compression_type compression_type)
 {
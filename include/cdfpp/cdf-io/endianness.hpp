@@ -49,6 +49,10 @@ static_assert(host_is_big_endian || host_is_little_endian, "Mixed-endian platfor
 #include <stdint.h>
 #include <type_traits>
 
+#ifndef CDFPP_NO_SIMD
+#include "../vectorized/endianness.hpp"
+#endif
+
 namespace cdf::endianness
 {
 
@@ -161,12 +165,17 @@ inline void _impl_decode_v(value_t* data, std::size_t size)
     if constexpr (sizeof(value_t) > 1 and not std::is_same_v<host_endianness_t, src_endianess_t>)
     {
         CDFPP_ASSERT(data != nullptr);
-        if (size > 0)
+#ifndef CDFPP_NO_SIMD
+        /* below a few vectors the dispatch overhead isn't worth it */
+        if (size >= 64)
+        {
+            vectorized_byte_swap(data, size);
+            return;
+        }
+#endif
+        for (auto i = 0UL; i < size; i++)
         {
-            for (auto i = 0UL; i < size; i++)
-            {
-                data[i] = byte_swap(data[i]);
-            }
+            data[i] = byte_swap(data[i]);
         }
     }
 }
@@ -29,22 +29,54 @@
 
 #include <cstddef>
 #include <libdeflate.h>
+#include <memory>
 #include <vector>
 
 namespace cdf::io::libdeflate
 {
 namespace _internal
 {
+    struct decompressor_deleter
+    {
+        void operator()(libdeflate_decompressor* d) const noexcept
+        {
+            libdeflate_free_decompressor(d);
+        }
+    };
+
+    struct compressor_deleter
+    {
+        void operator()(libdeflate_compressor* c) const noexcept { libdeflate_free_compressor(c); }
+    };
+
+    /* (de)compressors are kept per thread since setting them up costs more than small blocks */
+    inline libdeflate_decompressor* thread_decompressor()
+    {
+        thread_local std::unique_ptr<libdeflate_decompressor, decompressor_deleter> decompressor {
+            libdeflate_alloc_decompressor()
+        };
+        return decompressor.get();
+    }
+
+    inline libdeflate_compressor* thread_compressor()
+    {
+        thread_local std::unique_ptr<libdeflate_compressor, compressor_deleter> compressor {
+            libdeflate_alloc_compressor(6)
+        };
+        return compressor.get();
+    }
+
     template <typename T>
     CDF_WARN_UNUSED_RESULT std::size_t impl_inflate(
         const T& input, char* output, const std::size_t output_size)
     {
 
-        auto decompressor = libdeflate_alloc_decompressor();
+        auto decompressor = thread_decompressor();
+        if (!decompressor)
+            return 0;
         std::size_t length;
         auto result = libdeflate_gzip_decompress(
             decompressor, input.data(), std::size(input), output, output_size, &length);
-        libdeflate_free_decompressor(decompressor);
         if (result == LIBDEFLATE_SUCCESS)
         {
             return length;
@@ -58,14 +90,13 @@ namespace _internal
     template <typename T>
     CDF_WARN_UNUSED_RESULT no_init_vector<char> impl_deflate(const T& input)
     {
-        auto compressor = libdeflate_alloc_compressor(6);
+        auto compressor = thread_compressor();
         if (!compressor)
             return {};
         no_init_vector<char> result(
             libdeflate_gzip_compress_bound(compressor, std::size(input)));
         auto compressed_size = libdeflate_gzip_compress(
             compressor, input.data(), std::size(input), result.data(), std::size(result));
-        libdeflate_free_compressor(compressor);
         if (compressed_size > 0)
         {
             result.resize(compressed_size);
@@ -28,20 +28,26 @@
 #include "../desc-records.hpp"
 #include "./records-loading.hpp"
 #include "cdfpp/attribute.hpp"
+#include <string>
+#include <vector>
 
 namespace cdf::io::attribute
 {
 
 template <cdf_r_z type, typename cdf_version_tag_t, bool iso_8859_1_to_utf8, typename ADR_t,
     typename context_t>
-Attribute::attr_data_t load_data(
-    context_t& context, const ADR_t& ADR, std::vector<uint32_t>& var_num)
+Attribute::attr_data_t load_data(context_t& context, const ADR_t& ADR,
+    std::vector<uint32_t>& var_num, const common::cdf_repr& repr)
 {
     Attribute::attr_data_t values;
+    const bool variable_scope
+        = ADR.scope == cdf_attr_scope::variable || ADR.scope == cdf_attr_scope::variable_assumed;
     std::for_each(begin_AEDR<type>(ADR, context), end_AEDR<type>(ADR, context),
         [&](auto& blk)
         {
             auto& [offset, AEDR] = blk;
+            if (variable_scope and not common::is_selected(repr, AEDR.Num))
+                return;
             std::size_t element_size = cdf_type_size(CDF_Types { AEDR.DataType });
             data_t data
                 = new_data_container(AEDR.NumElements * element_size, CDF_Types { AEDR.DataType });
@@ -54,6 +60,91 @@ Attribute::attr_data_t load_data(
     return values;
 }
 
+/* position and type of one AEDR payload, enough to decode it later */
+struct aedr_desc_t
+{
+    std::size_t offset;
+    std::size_t count;
+    CDF_Types type;
+    uint32_t var_num;
+};
+
+template <cdf_r_z type, typename ADR_t, typename context_t>
+std::vector<aedr_desc_t> describe_entries(context_t& context, const ADR_t& ADR)
+{
+    std::vector<aedr_desc_t> entries;
+    std::for_each(begin_AEDR<type>(ADR, context), end_AEDR<type>(ADR, context),
+        [&](auto& blk)
+        {
+            auto& [offset, AEDR] = blk;
+            entries.push_back({ offset + packed_size(AEDR),
+                static_cast<std::size_t>(AEDR.NumElements), CDF_Types { AEDR.DataType },
+                static_cast<uint32_t>(AEDR.Num) });
+        });
+    return entries;
+}
+
+template <bool iso_8859_1_to_utf8, typename stream_t>
+data_t load_entry(stream_t& stream, const aedr_desc_t& entry, cdf_encoding encoding)
+{
+    data_t data = new_data_container(entry.count * cdf_type_size(entry.type), entry.type);
+    stream.read(data.bytes_ptr(), entry.offset, entry.count * cdf_type_size(entry.type));
+    return load_values<iso_8859_1_to_utf8>(std::move(data), encoding);
+}
+
+/*
+ * Metadata only flavor of load_all, only ADRs and AEDRs headers are read, entries values
+ * are read and decoded on first access through the attribute.
+ */
+template <typename cdf_version_tag_t, bool iso_8859_1_to_utf8, typename context_t>
+bool load_all_lazy(context_t& context, common::cdf_repr& repr)
+{
+    std::for_each(begin_ADR(context), end_ADR(context),
+        [&](auto& blk)
+        {
+            auto& [offset, ADR] = blk;
+            std::vector<aedr_desc_t> entries = [&, &ADR = ADR]() -> std::vector<aedr_desc_t>
+            {
+                if (ADR.AzEDRhead != 0)
+                    return describe_entries<cdf_r_z::z>(context, ADR);
+                else if (ADR.AgrEDRhead != 0)
+                    return describe_entries<cdf_r_z::r>(context, ADR);
+                return {};
+            }();
+            const std::string name = ADR.Name.value;
+            const auto encoding = context.encoding();
+            if (ADR.scope == cdf_attr_scope::global
+                || ADR.scope == cdf_attr_scope::global_assumed)
+            {
+                repr.attributes[name] = Attribute { name,
+                    [stream = context.buffer, entries = std::move(entries), encoding]() mutable
+                    {
+                        Attribute::attr_data_t values;
+                        values.reserve(std::size(entries));
+                        for (const auto& entry : entries)
+                            values.emplace_back(
+                                load_entry<iso_8859_1_to_utf8>(stream, entry, encoding));
+                        return values;
+                    } };
+            }
+            else if (ADR.scope == cdf_attr_scope::variable
+                || ADR.scope == cdf_attr_scope::variable_assumed)
+            {
+                for (const auto& entry : entries)
+                {
+                    if (entry.var_num >= std::size(repr.var_attributes)
+                        or not common::is_selected(repr, entry.var_num))
+                        continue;
+                    repr.var_attributes[entry.var_num][name] = VariableAttribute { name,
+                        lazy_data { [stream = context.buffer, entry, encoding]() mutable
+                            { return load_entry<iso_8859_1_to_utf8>(stream, entry, encoding); },
+                            entry.type } };
+                }
+            }
+        });
+    return true;
+}
+
 template <typename cdf_version_tag_t, bool iso_8859_1_to_utf8, typename context_t>
 bool load_all(context_t& context, common::cdf_repr& repr)
 {
@@ -66,10 +157,10 @@ bool load_all(context_t& context, common::cdf_repr& repr)
             {
                 if (ADR.AzEDRhead != 0)
                     return load_data<cdf_r_z::z, cdf_version_tag_t, iso_8859_1_to_utf8>(
-                        context, ADR, var_nums);
+                        context, ADR, var_nums, repr);
                 else if (ADR.AgrEDRhead != 0)
                     return load_data<cdf_r_z::r, cdf_version_tag_t, iso_8859_1_to_utf8>(
-                        context, ADR, var_nums);
+                        context, ADR, var_nums, repr);
                 return {};
             }();
             common::add_attribute(repr, ADR.scope, ADR.Name.value, std::move(data), var_nums);
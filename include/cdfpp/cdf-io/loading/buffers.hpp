@@ -27,13 +27,17 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cerrno>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 
+#include "cdfpp/no_init_vector.hpp"
+
 #if __has_include(<sys/mman.h>)
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -229,6 +233,34 @@ template <typename array_t>
 using owning_array_adapter = array_adapter<array_t, true>;
 
 
+/*
+ * Access pattern hint given to the kernel for the whole mapping, populate pre-faults
+ * the mapping (MAP_POPULATE) so no page fault happens while parsing. drop_behind reads
+ * sequentially and evicts values pages from the page cache once they were copied out.
+ */
+enum class mmap_access
+{
+    normal,
+    sequential,
+    willneed,
+    populate,
+    drop_behind
+};
+
+#ifdef USE_MMAP
+/* [begin, end) pages covering a byte range, or only the pages fully inside it */
+[[nodiscard]] inline std::pair<std::size_t, std::size_t> page_range(
+    std::size_t offset, std::size_t size, bool inner) noexcept
+{
+    static const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    if (inner)
+        return { (offset + page_size - 1) / page_size * page_size,
+            (offset + size) / page_size * page_size };
+    return { offset / page_size * page_size,
+        (offset + size + page_size - 1) / page_size * page_size };
+}
+#endif
+
 struct mmap_adapter
 {
 #ifdef USE_MMAP
@@ -236,13 +268,14 @@ struct mmap_adapter
 #endif
     char* mapped_file = nullptr;
     std::size_t f_size = 0UL;
+    bool drop_behind = false;
     using implements_view = std::true_type;
 #ifdef USE_MapViewOfFile
     HANDLE hMapFile = NULL;
     HANDLE hFile = NULL;
 #endif
 
-    mmap_adapter(const std::string& path)
+    mmap_adapter(const std::string& path, [[maybe_unused]] mmap_access access = mmap_access::normal)
     {
 
         if (std::filesystem::exists(path))
@@ -255,14 +288,25 @@ struct mmap_adapter
                 {
 
                     {
-                        mapped_file = static_cast<char*>(mmap(
-                            nullptr, this->f_size, PROT_READ, MAP_FILE | MAP_PRIVATE, fd, 0UL));
+                        int flags = MAP_FILE | MAP_PRIVATE;
+#ifdef MAP_POPULATE
+                        if (access == mmap_access::populate)
+                            flags |= MAP_POPULATE;
+#endif
+                        mapped_file = static_cast<char*>(
+                            mmap(nullptr, this->f_size, PROT_READ, flags, fd, 0UL));
                         if (mapped_file == MAP_FAILED)
                         {
                             mapped_file = nullptr;
                             close(fd);
                             fd = -1;
                         }
+                        else if (access == mmap_access::sequential
+                            or access == mmap_access::drop_behind)
+                            madvise(mapped_file, this->f_size, MADV_SEQUENTIAL);
+                        else if (access == mmap_access::willneed)
+                            madvise(mapped_file, this->f_size, MADV_WILLNEED);
+                        drop_behind = access == mmap_access::drop_behind;
                     }
                 }
 #endif
@@ -318,6 +362,35 @@ struct mmap_adapter
 
     auto view(const std::size_t offset) const { return mapped_file + offset; }
 
+    /* asks the kernel to start reading the pages of a range that is about to be decoded */
+    void prefetch([[maybe_unused]] std::size_t offset, [[maybe_unused]] std::size_t size) const
+    {
+#ifdef USE_MMAP
+        const auto [begin, end] = page_range(offset, size, false);
+        madvise(mapped_file + begin, std::min(end, f_size) - begin, MADV_WILLNEED);
+#endif
+    }
+
+    /*
+     * With mmap_access::drop_behind, drops the pages of a range which values were copied out
+     * from the mapping and the page cache. Pages shared with neighbour ranges are kept.
+     */
+    void release([[maybe_unused]] std::size_t offset, [[maybe_unused]] std::size_t size) const
+    {
+#ifdef USE_MMAP
+        if (not drop_behind)
+            return;
+        const auto [begin, end] = page_range(offset, size, true);
+        if (end <= begin)
+            return;
+        madvise(mapped_file + begin, end - begin, MADV_DONTNEED);
+#ifdef POSIX_FADV_DONTNEED
+        ::posix_fadvise(fd, static_cast<off_t>(begin), static_cast<off_t>(end - begin),
+            POSIX_FADV_DONTNEED);
+#endif
+#endif
+    }
+
     bool is_valid() const
     {
 #ifdef USE_MMAP
@@ -330,11 +403,55 @@ struct mmap_adapter
 };
 
 
+#ifdef USE_MMAP
+/*
+ * Records are still parsed from the mapping but bulk reads (VVR/CVVR payloads) are done with
+ * pread, on network file systems page faults serialize I/O while large reads are issued
+ * as few big requests. prefetch hints the kernel to start reading ranges asynchronously.
+ */
+struct pread_adapter : mmap_adapter
+{
+    using prefers_reads = std::true_type;
+
+    pread_adapter(const std::string& path) : mmap_adapter(path) { }
+
+    using mmap_adapter::read;
+
+    void read(char* dest, std::size_t offset, std::size_t size)
+    {
+        while (size != 0)
+        {
+            const auto count = ::pread(fd, dest, size, static_cast<off_t>(offset));
+            if (count <= 0)
+            {
+                if (count == -1 and errno == EINTR)
+                    continue;
+                // let the mapping deal with it (or fault) like mmap_adapter would
+                std::memcpy(dest, mapped_file + offset, size);
+                return;
+            }
+            dest += count;
+            offset += static_cast<std::size_t>(count);
+            size -= static_cast<std::size_t>(count);
+        }
+    }
+
+    void prefetch([[maybe_unused]] std::size_t offset, [[maybe_unused]] std::size_t size) const
+    {
+#ifdef POSIX_FADV_WILLNEED
+        ::posix_fadvise(
+            fd, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#endif
+    }
+};
+#endif
+
 template <class buffer_t>
 struct shared_buffer_t
 {
     shared_buffer_t() = delete;
     using implements_view = typename buffer_t::implements_view;
+    using buffer_type = buffer_t;
 
     shared_buffer_t(std::shared_ptr<buffer_t>&& buffer) : p_buffer { std::move(buffer) } { }
 
@@ -383,6 +500,21 @@ struct shared_buffer_t
 
     inline bool is_valid() const { return p_buffer->is_valid(); }
 
+    inline void prefetch(std::size_t offset, std::size_t size) const
+        requires requires(const buffer_t& b) { b.prefetch(0UL, 0UL); }
+    {
+        p_buffer->prefetch(offset, size);
+    }
+
+    inline void release(std::size_t offset, std::size_t size) const
+        requires requires(const buffer_t& b) { b.release(0UL, 0UL); }
+    {
+        p_buffer->release(offset, size);
+    }
+
+    /* keeps the underlying buffer alive, for data referencing it without copy */
+    [[nodiscard]] inline std::shared_ptr<const void> owner() const { return p_buffer; }
+
 private:
     std::shared_ptr<buffer_t> p_buffer;
 };
@@ -404,9 +536,79 @@ inline auto make_shared_array_adapter(const char* const data, std::size_t size)
     return shared_buffer_t(std::make_shared<array_adapter<const char* const>>(data, size));
 }
 
-inline auto make_shared_file_adapter(const std::string& path)
+inline auto make_shared_file_adapter(
+    const std::string& path, mmap_access access = mmap_access::normal)
+{
+    return shared_buffer_t(std::make_shared<mmap_adapter>(path, access));
+}
+
+#ifdef USE_MMAP
+inline auto make_shared_pread_file_adapter(const std::string& path)
+{
+    return shared_buffer_t(std::make_shared<pread_adapter>(path));
+}
+
+/*
+ * Reads the whole file into a (huge pages backed when large enough) no_init_vector.
+ * With direct, the page cache is bypassed (O_DIRECT) when the destination is suitably
+ * aligned, which is the case for files larger than a few MiB, this silently falls back to
+ * buffered reads when the file system refuses O_DIRECT.
+ */
+inline std::optional<no_init_vector<char>> read_whole_file(
+    const std::string& path, bool direct = false)
 {
-    return shared_buffer_t(std::make_shared<mmap_adapter>(path));
+    constexpr std::size_t direct_alignment = 4096;
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec or size == 0)
+        return std::nullopt;
+    int fd = -1;
+#ifdef O_DIRECT
+    if (direct)
+        fd = ::open(path.c_str(), O_RDONLY | O_DIRECT);
+#endif
+    if (fd == -1)
+    {
+        direct = false;
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            return std::nullopt;
+    }
+    no_init_vector<char> data(
+        direct ? (size + direct_alignment - 1) / direct_alignment * direct_alignment : size);
+#ifdef O_DIRECT
+    if (direct and reinterpret_cast<std::uintptr_t>(data.data()) % direct_alignment != 0)
+    {
+        direct = false;
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_DIRECT);
+    }
+#endif
+    std::size_t done = 0;
+    while (done < size)
+    {
+        const auto count = ::pread(fd, data.data() + done,
+            direct ? std::size(data) - done : size - done, static_cast<off_t>(done));
+        if (count == -1 and errno == EINTR)
+            continue;
+#ifdef O_DIRECT
+        if (count == -1 and direct and errno == EINVAL)
+        {
+            direct = false;
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_DIRECT);
+            continue;
+        }
+#endif
+        if (count <= 0)
+        {
+            ::close(fd);
+            return std::nullopt;
+        }
+        done += static_cast<std::size_t>(count);
+    }
+    ::close(fd);
+    data.resize(size);
+    return data;
 }
+#endif
 
 }
@@ -0,0 +1,450 @@
+/*------------------------------------------------------------------------------
+-- The MIT License (MIT)
+--
+-- Copyright © 2024, Laboratory of Plasma Physics- CNRS
+--
+-- Permission is hereby granted, free of charge, to any person obtaining a copy
+-- of this software and associated documentation files (the “Software”), to deal
+-- in the Software without restriction, including without limitation the rights
+-- to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+-- of the Software, and to permit persons to whom the Software is furnished to do
+-- so, subject to the following conditions:
+--
+-- The above copyright notice and this permission notice shall be included in all
+-- copies or substantial portions of the Software.
+--
+-- THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+-- INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+-- PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+-- HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+-- OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+-- SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+-------------------------------------------------------------------------------*/
+/*-- Author : Alexis Jeandet
+-- Mail : alexis.jeandet@member.fsf.org
+----------------------------------------------------------------------------*/
+#pragma once
+#include "../common.hpp"
+#include "./variable.hpp"
+#include "cdfpp/cdf-data.hpp"
+#include "cdfpp/cdf-enums.hpp"
+#include "cdfpp/cdf-file.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/*
+ * On disk cache of parsed files structure, lets a process that reopens the same files skip
+ * the CDR/GDR/ADR/AEDR/VDR/VXR chains walk. An entry stores attributes values, variables
+ * descriptions and their blocks index, a cache hit only maps the file and attaches lazy
+ * loaders to the cached blocks.
+ * Entries are keyed by (absolute path, size, modification time, strings conversion) and
+ * also check a hash of the beginning of the file, they are written atomically so several
+ * processes can share the same directory.
+ */
+namespace cdf::io::header_cache
+{
+
+namespace _details
+{
+    inline constexpr std::string_view magic = "CDFPPHC1";
+    inline constexpr std::size_t hashed_size = 4096UL;
+
+    struct state_t
+    {
+        std::mutex mutex;
+        std::filesystem::path directory;
+    };
+
+    /* shared by all translation units, unlike an anonymous namespace static */
+    inline state_t& state()
+    {
+        static state_t s;
+        return s;
+    }
+
+    [[nodiscard]] inline uint64_t fnv1a(const char* data, std::size_t size, uint64_t hash)
+    {
+        for (std::size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    [[nodiscard]] inline uint64_t fnv1a(std::string_view data)
+    {
+        return fnv1a(std::data(data), std::size(data), 0xcbf29ce484222325ULL);
+    }
+
+    /* identifies the file content a cache entry was built from */
+    struct file_id_t
+    {
+        std::string path;
+        uint64_t size;
+        int64_t mtime;
+        uint64_t head_hash;
+    };
+
+    template <typename buffer_t>
+    [[nodiscard]] std::optional<file_id_t> file_id(const std::string& path, buffer_t& buffer)
+    {
+        std::error_code ec;
+        const auto absolute = std::filesystem::absolute(path, ec);
+        if (ec)
+            return std::nullopt;
+        const auto size = std::filesystem::file_size(absolute, ec);
+        if (ec)
+            return std::nullopt;
+        const auto mtime = std::filesystem::last_write_time(absolute, ec);
+        if (ec)
+            return std::nullopt;
+        std::vector<char> head(std::min<std::size_t>(size, hashed_size));
+        buffer.read(std::data(head), 0UL, std::size(head));
+        return file_id_t { absolute.string(), static_cast<uint64_t>(size),
+            static_cast<int64_t>(mtime.time_since_epoch().count()),
+            fnv1a(std::data(head), std::size(head), 0xcbf29ce484222325ULL) };
+    }
+
+    [[nodiscard]] inline std::filesystem::path entry_path(
+        const std::filesystem::path& directory, const file_id_t& id, bool iso_8859_1_to_utf8)
+    {
+        return directory
+            / fmt::format("{:016x}.cdfhc",
+                fnv1a(fmt::format("{}:{}:{}:{}", id.path, id.size, id.mtime,
+                    iso_8859_1_to_utf8 ? 1 : 0)));
+    }
+
+    struct writer_t
+    {
+        std::string buffer;
+
+        template <typename T>
+            requires std::is_trivially_copyable_v<T>
+        inline void put(const T& value)
+        {
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        inline void put(const std::string& value)
+        {
+            put(static_cast<uint64_t>(std::size(value)));
+            buffer.append(value);
+        }
+
+        inline void put(const data_t& value)
+        {
+            put(value.type());
+            put(static_cast<uint64_t>(value.bytes()));
+            buffer.append(value.bytes_ptr(), value.bytes());
+        }
+    };
+
+    struct reader_t
+    {
+        std::string_view buffer;
+        std::size_t position = 0UL;
+        bool valid = true;
+
+        template <typename T>
+            requires std::is_trivially_copyable_v<T>
+        inline T get()
+        {
+            T value {};
+            if (position + sizeof(T) > std::size(buffer))
+            {
+                valid = false;
+                return value;
+            }
+            std::memcpy(&value, std::data(buffer) + position, sizeof(T));
+            position += sizeof(T);
+            return value;
+        }
+
+        inline std::string_view get_bytes()
+        {
+            const auto size = get<uint64_t>();
+            if (not valid or size > std::size(buffer) - position)
+            {
+                valid = false;
+                return {};
+            }
+            auto bytes = buffer.substr(position, size);
+            position += size;
+            return bytes;
+        }
+
+        inline std::string get_string() { return std::string { get_bytes() }; }
+
+        /*
+         * Reads a count of items taking at least item_bytes each, counts that can't fit in
+         * the remaining bytes come from a truncated or corrupted entry and invalidate it
+         */
+        inline std::size_t get_count(std::size_t item_bytes)
+        {
+            const auto count = get<uint64_t>();
+            if (not valid or count > (std::size(buffer) - position) / item_bytes)
+            {
+                valid = false;
+                return 0UL;
+            }
+            return static_cast<std::size_t>(count);
+        }
+
+        inline data_t get_data()
+        {
+            const auto type = get<CDF_Types>();
+            const auto bytes = get_bytes();
+            if (type != CDF_Types::CDF_NONE and cdf_type_size(type) == 0UL)
+                valid = false;
+            if (not valid)
+                return {};
+            auto data = new_data_container(std::size(bytes), type);
+            if (std::size(bytes))
+                std::memcpy(data.bytes_ptr(), std::data(bytes), std::size(bytes));
+            return data;
+        }
+    };
+
+    inline void put_header(writer_t& w, const file_id_t& id)
+    {
+        w.buffer.append(magic);
+        w.put(id.size);
+        w.put(id.mtime);
+        w.put(id.head_hash);
+        w.put(id.path);
+    }
+
+    [[nodiscard]] inline bool check_header(reader_t& r, const file_id_t& id)
+    {
+        if (not r.buffer.starts_with(magic))
+            return false;
+        r.position = std::size(magic);
+        return r.get<uint64_t>() == id.size and r.get<int64_t>() == id.mtime
+            and r.get<uint64_t>() == id.head_hash and r.get_string() == id.path and r.valid;
+    }
+
+    [[nodiscard]] inline std::string serialize(
+        const CDF& cdf, const common::file_layout_t& layout, const file_id_t& id)
+    {
+        writer_t w;
+        put_header(w, id);
+        w.put(cdf.majority);
+        std::apply([&w](auto... version) { (w.put(version), ...); }, cdf.distribution_version);
+        w.put(cdf.compression);
+        w.put(layout.encoding);
+        w.put(static_cast<uint64_t>(std::size(cdf.attributes)));
+        for (const auto& [name, attribute] : cdf.attributes)
+        {
+            w.put(name);
+            w.put(static_cast<uint64_t>(std::size(attribute)));
+            for (const auto& entry : attribute)
+                w.put(entry);
+        }
+        w.put(static_cast<uint64_t>(std::size(cdf.variables)));
+        for (const auto& [name, variable] : cdf.variables)
+        {
+            w.put(name);
+            w.put(static_cast<uint64_t>(variable.number()));
+            w.put(variable.type());
+            w.put(variable.is_nrv());
+            w.put(variable.compression_type());
+            w.put(static_cast<uint64_t>(std::size(variable.shape())));
+            for (const auto dim : variable.shape())
+                w.put(dim);
+            const auto& blocks = layout.var_blocks.at(name);
+            w.put(static_cast<uint64_t>(std::size(blocks)));
+            for (const auto& block : blocks)
+            {
+                w.put(static_cast<uint64_t>(block.first));
+                w.put(static_cast<uint64_t>(block.last));
+                w.put(static_cast<uint64_t>(block.offset));
+                w.put(static_cast<uint64_t>(block.size));
+                w.put(block.compressed);
+            }
+            w.put(static_cast<uint64_t>(std::size(variable.attributes)));
+            for (const auto& [attr_name, attribute] : variable.attributes)
+            {
+                w.put(attr_name);
+                w.put(*attribute);
+            }
+        }
+        return std::move(w.buffer);
+    }
+
+    template <bool iso_8859_1_to_utf8, typename buffer_t>
+    [[nodiscard]] std::optional<CDF> deserialize(
+        std::string_view content, const file_id_t& id, buffer_t& buffer)
+    {
+        reader_t r { content };
+        if (not check_header(r, id))
+            return std::nullopt;
+        CDF cdf;
+        cdf.majority = r.get<cdf_majority>();
+        std::apply([&r](auto&... version)
+            { ((version = r.get<std::decay_t<decltype(version)>>()), ...); },
+            cdf.distribution_version);
+        cdf.compression = r.get<cdf_compression_type>();
+        cdf.lazy_loaded = true;
+        const auto encoding = r.get<cdf_encoding>();
+        for (auto count = r.get<uint64_t>(); r.valid and count > 0; count--)
+        {
+            auto name = r.get_string();
+            Attribute::attr_data_t entries(r.get_count(sizeof(CDF_Types) + sizeof(uint64_t)));
+            if (not r.valid or std::empty(name))
+                return std::nullopt;
+            for (auto& entry : entries)
+                entry = r.get_data();
+            cdf.attributes[name] = Attribute { name, std::move(entries) };
+        }
+        for (auto count = r.get<uint64_t>(); r.valid and count > 0; count--)
+        {
+            auto name = r.get_string();
+            const auto number = r.get<uint64_t>();
+            const auto type = r.get<CDF_Types>();
+            const auto is_nrv = r.get<bool>();
+            const auto compression = r.get<cdf_compression_type>();
+            Variable::shape_t shape(r.get_count(sizeof(uint32_t)));
+            if (not r.valid or std::empty(shape) or std::empty(name)
+                or cdf_type_size(type) == 0UL)
+                return std::nullopt;
+            for (auto& dim : shape)
+                dim = r.get<uint32_t>();
+            std::vector<common::var_block_t> blocks(
+                r.get_count(4 * sizeof(uint64_t) + sizeof(bool)));
+            if (not r.valid)
+                return std::nullopt;
+            for (auto& block : blocks)
+            {
+                block.first = r.get<uint64_t>();
+                block.last = r.get<uint64_t>();
+                block.offset = r.get<uint64_t>();
+                block.size = r.get<uint64_t>();
+                block.compressed = r.get<bool>();
+            }
+            const std::size_t record_size = cdf_type_size(type)
+                * std::accumulate(std::cbegin(shape) + 1, std::cend(shape), 1UL,
+                    std::multiplies<std::size_t>());
+            using loader_t = variable::defered_variable_loader<iso_8859_1_to_utf8, buffer_t>;
+            loader_t loader { buffer, encoding, type, shape[0], record_size, compression, shape,
+                cdf.majority, std::move(blocks) };
+            auto& variable = cdf.variables[name] = Variable { name, number,
+                lazy_data { loader, loader, loader, type, loader.values_row_major() },
+                std::move(shape), cdf.majority, is_nrv, compression };
+            for (auto attr_count = r.get<uint64_t>(); r.valid and attr_count > 0; attr_count--)
+            {
+                auto attr_name = r.get_string();
+                auto value = r.get_data();
+                if (not r.valid or std::empty(attr_name))
+                    return std::nullopt;
+                variable.attributes[attr_name] = VariableAttribute { attr_name, std::move(value) };
+            }
+        }
+        if (not r.valid)
+            return std::nullopt;
+        return cdf;
+    }
+
+    [[nodiscard]] inline std::optional<std::string> read_entry(const std::filesystem::path& path)
+    {
+        std::ifstream file { path, std::ios::binary | std::ios::ate };
+        if (not file)
+            return std::nullopt;
+        std::string content(static_cast<std::size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        if (not file.read(std::data(content), static_cast<std::streamsize>(std::size(content))))
+            return std::nullopt;
+        return content;
+    }
+
+    /* written to a temporary file then renamed so readers never see a partial entry */
+    inline void write_entry(const std::filesystem::path& path, const std::string& content)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        const auto tmp = std::filesystem::path { path }.concat(
+            fmt::format(".{:08x}.tmp", std::random_device {}()));
+        {
+            std::ofstream file { tmp, std::ios::binary | std::ios::trunc };
+            if (not file)
+                return;
+            file.write(std::data(content), static_cast<std::streamsize>(std::size(content)));
+            if (not file)
+            {
+                file.close();
+                std::filesystem::remove(tmp, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tmp, path, ec);
+        if (ec)
+            std::filesystem::remove(tmp, ec);
+    }
+}
+
+/* Enables the cache and stores entries in directory, an empty path disables it (default) */
+inline void set_directory(const std::filesystem::path& directory)
+{
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    s.directory = directory;
+}
+
+[[nodiscard]] inline std::filesystem::path directory()
+{
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    return s.directory;
+}
+
+[[nodiscard]] inline bool enabled()
+{
+    return not std::empty(directory());
+}
+
+/*
+ * Returns the cached structure of the file mapped by buffer, std::nullopt when there is no
+ * valid entry for it. Cached variables are lazy and read their values from buffer.
+ */
+template <bool iso_8859_1_to_utf8, typename buffer_t>
+[[nodiscard]] std::optional<CDF> load(const std::string& path, buffer_t& buffer)
+{
+    const auto dir = directory();
+    if (std::empty(dir))
+        return std::nullopt;
+    if (auto id = _details::file_id(path, buffer))
+    {
+        if (auto content
+            = _details::read_entry(_details::entry_path(dir, *id, iso_8859_1_to_utf8)))
+            return _details::deserialize<iso_8859_1_to_utf8>(*content, *id, buffer);
+    }
+    return std::nullopt;
+}
+
+/* Stores the structure of a lazily loaded file, layout must have been filled while parsing */
+template <typename buffer_t>
+void store(const std::string& path, buffer_t& buffer, bool iso_8859_1_to_utf8, const CDF& cdf,
+    const common::file_layout_t& layout)
+{
+    const auto dir = directory();
+    if (std::empty(dir))
+        return;
+    if (auto id = _details::file_id(path, buffer))
+        _details::write_entry(_details::entry_path(dir, *id, iso_8859_1_to_utf8),
+            _details::serialize(cdf, layout, *id));
+}
+
+}
@@ -30,22 +30,64 @@
 #include "../endianness.hpp"
 #include "./attribute.hpp"
 #include "./buffers.hpp"
+#include "./header-cache.hpp"
 #include "./records-loading.hpp"
 #include "./variable.hpp"
 #include "cdfpp/cdf-enums.hpp"
 #include "cdfpp/cdf-file.hpp"
 #include <algorithm>
+#include <filesystem>
+#include <fmt/core.h>
 #include <fstream>
 #include <iostream>
 #include <numeric>
 #include <optional>
+#include <regex>
+#include <string>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace cdf::io
 {
 
+/*
+ * How a file is read by load(path, ...):
+ *  - automatic: lazy loads map the file, eager loads of small files read it at once and
+ *    larger ones map it with a sequential access hint.
+ *  - mmap*: map the file, with the given access hint (see buffers::mmap_access).
+ *  - mmap_drop_behind: map the file and evict values pages from the page cache once they
+ *    were decoded, for large one shot reads that should not evict other files pages.
+ *  - pread: map the file for records but read values with pread and read-ahead hints.
+ *  - read_all: read the whole file into memory (huge pages backed when large).
+ *  - direct: same as read_all bypassing the page cache (O_DIRECT) when possible.
+ * Policies not available on the platform fall back to mmap.
+ */
+using variable_selector = common::variable_selector;
+
+enum class io_policy
+{
+    automatic,
+    mmap,
+    mmap_sequential,
+    mmap_willneed,
+    mmap_populate,
+    mmap_drop_behind,
+    pread,
+    read_all,
+    direct
+};
+
 namespace
 {
+    /* optional parsing behaviors, see load_metadata and load(path, selector, ...) */
+    struct parse_options_t
+    {
+        bool lazy_attributes = false;
+        variable_selector selector = {};
+        common::file_layout_t* layout = nullptr;
+    };
+
     template <typename buffer_t>
     common::magic_numbers_t get_magic(buffer_t& buffer)
     {
@@ -80,16 +122,27 @@ namespace
     }
 
     template <bool iso_8859_1_to_utf8, typename parsing_context_t>
-    [[nodiscard]] std::optional<CDF> impl_parse_cdf(
-        parsing_context_t& parsing_context, bool lazy_load = false)
+    [[nodiscard]] std::optional<CDF> impl_parse_cdf(parsing_context_t& parsing_context,
+        bool lazy_load = false, const parse_options_t& options = {})
     {
         common::cdf_repr repr { parsing_context.gdr.NzVars + parsing_context.gdr.NrVars };
         repr.majority = parsing_context.majority;
         repr.distribution_version = parsing_context.distribution_version();
         repr.compression_type = parsing_context.compression_type;
         repr.lazy = lazy_load;
-        if (!attribute::load_all<typename parsing_context_t::version_tag, iso_8859_1_to_utf8>(
-                parsing_context, repr))
+        repr.selector = options.selector;
+        repr.layout = options.layout;
+        if (options.layout)
+            options.layout->encoding = parsing_context.encoding();
+        variable::select(parsing_context, repr);
+        if (options.lazy_attributes)
+        {
+            if (!attribute::load_all_lazy<typename parsing_context_t::version_tag,
+                    iso_8859_1_to_utf8>(parsing_context, repr))
+                return std::nullopt;
+        }
+        else if (!attribute::load_all<typename parsing_context_t::version_tag,
+                     iso_8859_1_to_utf8>(parsing_context, repr))
             return std::nullopt;
         if (!variable::load_all<typename parsing_context_t::version_tag, iso_8859_1_to_utf8>(
                 parsing_context, repr, lazy_load))
@@ -98,8 +151,8 @@ namespace
     }
 
     template <typename cdf_version_tag_t, typename iso_8859_1_to_utf8, typename buffer_t>
-    [[nodiscard]] std::optional<CDF> parse_cdf(
-        buffer_t&& buffer, iso_8859_1_to_utf8, bool is_compressed = false, bool lazy_load = false)
+    [[nodiscard]] std::optional<CDF> parse_cdf(buffer_t&& buffer, iso_8859_1_to_utf8,
+        bool is_compressed = false, bool lazy_load = false, const parse_options_t& options = {})
     {
         if (is_compressed)
         {
@@ -114,7 +167,7 @@ namespace
                 auto parsing_ctx = make_parsing_context(cdf_version_tag_t {},
                     buffers::make_shared_array_adapter(std::move(data)), CPR.cType);
                 return impl_parse_cdf<common::with_iso_8859_1_to_utf8<iso_8859_1_to_utf8>>(
-                    parsing_ctx, lazy_load);
+                    parsing_ctx, lazy_load, options);
             }
             return std::nullopt;
         }
@@ -129,28 +182,28 @@ namespace
                     auto new_ctx = make_parsing_context(v2_5_or_more_tag {},
                         std::move(parsing_ctx.buffer), cdf_compression_type::no_compression);
                     return impl_parse_cdf<common::with_iso_8859_1_to_utf8<iso_8859_1_to_utf8>>(
-                        new_ctx, lazy_load);
+                        new_ctx, lazy_load, options);
                 }
                 else
                 {
                     auto new_ctx = make_parsing_context(v2_4_or_less_tag {},
                         std::move(parsing_ctx.buffer), cdf_compression_type::no_compression);
                     return impl_parse_cdf<common::with_iso_8859_1_to_utf8<iso_8859_1_to_utf8>>(
-                        new_ctx, lazy_load);
+                        new_ctx, lazy_load, options);
                 }
             }
             else
             {
                 return impl_parse_cdf<common::with_iso_8859_1_to_utf8<iso_8859_1_to_utf8>>(
-                    parsing_ctx, lazy_load);
+                    parsing_ctx, lazy_load, options);
             }
         }
     }
 
     template <typename buffer_t, typename iso_8859_1_to_utf8>
     [[nodiscard]] auto _impl_load(buffer_t&& buffer, iso_8859_1_to_utf8 iso_8859_1_to_utf8_tag,
-        bool lazy_load = false) -> decltype(buffer.read(std::declval<char*>(), 0UL, 0UL),
-                                    std::optional<CDF> {})
+        bool lazy_load = false, const parse_options_t& options = {})
+        -> decltype(buffer.read(std::declval<char*>(), 0UL, 0UL), std::optional<CDF> {})
     {
         auto magic = get_magic(buffer);
         if (common::is_cdf(magic))
@@ -158,38 +211,268 @@ namespace
             if (common::is_v3x(magic))
             {
                 return parse_cdf<v3x_tag>(std::move(buffer), iso_8859_1_to_utf8_tag,
-                    common::is_compressed(magic), lazy_load);
+                    common::is_compressed(magic), lazy_load, options);
             }
             else
             {
                 return parse_cdf<v2x_tag>(std::move(buffer), iso_8859_1_to_utf8_tag,
-                    common::is_compressed(magic), lazy_load);
+                    common::is_compressed(magic), lazy_load, options);
             }
         }
         return std::nullopt;
     }
 
     template <typename buffer_t>
-    [[nodiscard]] auto impl_load(buffer_t&& buffer, bool iso_8859_1_to_utf8, bool lazy_load = false)
+    [[nodiscard]] auto impl_load(buffer_t&& buffer, bool iso_8859_1_to_utf8,
+        bool lazy_load = false, const parse_options_t& options = {})
     {
         if (iso_8859_1_to_utf8)
-            return _impl_load(std::move(buffer), common::iso_8859_1_to_utf8_t {}, lazy_load);
+            return _impl_load(std::move(buffer), common::iso_8859_1_to_utf8_t {}, lazy_load,
+                options);
         else
-            return _impl_load(std::move(buffer), common::no_iso_8859_1_to_utf8_t {}, lazy_load);
+            return _impl_load(std::move(buffer), common::no_iso_8859_1_to_utf8_t {}, lazy_load,
+                options);
+    }
+
+    /*
+     * Below this size reading the whole file is cheaper than faulting its pages in, above it
+     * mapping avoids a copy and lets row major values be used in place.
+     */
+    inline constexpr std::size_t read_all_threshold = 16UL * 1024UL * 1024UL;
+
+    [[nodiscard]] io_policy resolve_io_policy(
+        const std::string& path, bool lazy_load, io_policy policy)
+    {
+        if (policy != io_policy::automatic)
+            return policy;
+        if (lazy_load)
+            return io_policy::mmap;
+        std::error_code ec;
+        if (const auto size = std::filesystem::file_size(path, ec);
+            not ec and size < read_all_threshold)
+            return io_policy::read_all;
+        return io_policy::mmap_sequential;
+    }
+
+    /*
+     * Lazy loads through the header cache, on a miss the file is parsed as usual while
+     * recording variables blocks index and the entry is stored for the next load.
+     */
+    template <typename buffer_t>
+    [[nodiscard]] std::optional<CDF> load_cached(
+        const std::string& path, buffer_t& buffer, bool iso_8859_1_to_utf8)
+    {
+        if (auto cdf = iso_8859_1_to_utf8 ? header_cache::load<true>(path, buffer)
+                                          : header_cache::load<false>(path, buffer))
+            return cdf;
+        common::file_layout_t layout;
+        auto cdf = impl_load(buffer_t { buffer }, iso_8859_1_to_utf8, true, { .layout = &layout });
+        // whole file compressed CDFs are parsed from an inflated copy that can't be cached
+        if (cdf and cdf->compression == cdf_compression_type::no_compression)
+            header_cache::store(path, buffer, iso_8859_1_to_utf8, *cdf, layout);
+        return cdf;
+    }
+
+    [[nodiscard]] std::optional<CDF> load_mapped(const std::string& path,
+        bool iso_8859_1_to_utf8, bool lazy_load, const parse_options_t& options,
+        buffers::mmap_access access)
+    {
+        auto buffer = buffers::make_shared_file_adapter(path, access);
+        if (buffer.is_valid())
+        {
+            if (lazy_load and not options.lazy_attributes and not options.selector
+                and header_cache::enabled())
+                return load_cached(path, buffer, iso_8859_1_to_utf8);
+            return impl_load(std::move(buffer), iso_8859_1_to_utf8, lazy_load, options);
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] std::optional<CDF> load_file(const std::string& path, bool iso_8859_1_to_utf8,
+        bool lazy_load, io_policy policy, const parse_options_t& options = {})
+    {
+        policy = resolve_io_policy(path, lazy_load, policy);
+        switch (policy)
+        {
+            case io_policy::mmap_sequential:
+                return load_mapped(path, iso_8859_1_to_utf8, lazy_load, options,
+                    buffers::mmap_access::sequential);
+            case io_policy::mmap_willneed:
+                return load_mapped(path, iso_8859_1_to_utf8, lazy_load, options,
+                    buffers::mmap_access::willneed);
+            case io_policy::mmap_populate:
+                return load_mapped(path, iso_8859_1_to_utf8, lazy_load, options,
+                    buffers::mmap_access::populate);
+            case io_policy::mmap_drop_behind:
+                return load_mapped(path, iso_8859_1_to_utf8, lazy_load, options,
+                    buffers::mmap_access::drop_behind);
+#ifdef USE_MMAP
+            case io_policy::pread:
+            {
+                auto buffer = buffers::make_shared_pread_file_adapter(path);
+                if (buffer.is_valid())
+                {
+                    return impl_load(std::move(buffer), iso_8859_1_to_utf8, lazy_load, options);
+                }
+                return std::nullopt;
+            }
+            case io_policy::read_all:
+            case io_policy::direct:
+            {
+                if (auto data = buffers::read_whole_file(path, policy == io_policy::direct))
+                {
+                    return impl_load(buffers::make_shared_array_adapter(std::move(*data)),
+                        iso_8859_1_to_utf8, lazy_load, options);
+                }
+                return std::nullopt;
+            }
+#endif
+            default:
+                return load_mapped(path, iso_8859_1_to_utf8, lazy_load, options,
+                    buffers::mmap_access::normal);
+        }
     }
 } // namespace
 
 
-[[nodiscard]] std::optional<CDF> load(
-    const std::string& path, bool iso_8859_1_to_utf8 = true, bool lazy_load = true)
+[[nodiscard]] std::optional<CDF> load(const std::string& path, bool iso_8859_1_to_utf8 = true,
+    bool lazy_load = true, io_policy policy = io_policy::automatic)
+{
+    return load_file(path, iso_8859_1_to_utf8, lazy_load, policy);
+}
+
+/*
+ * Only loads variables for which selector returns true, other variables VDRs are skipped
+ * and their attributes entries are neither read nor decoded.
+ */
+[[nodiscard]] std::optional<CDF> load(const std::string& path, const variable_selector& selector,
+    bool iso_8859_1_to_utf8 = true, bool lazy_load = true, io_policy policy = io_policy::automatic)
+{
+    return load_file(path, iso_8859_1_to_utf8, lazy_load, policy, { .selector = selector });
+}
+
+/* Only loads the listed variables, see load(path, selector, ...) */
+[[nodiscard]] std::optional<CDF> load(const std::string& path,
+    const std::vector<std::string>& variables, bool iso_8859_1_to_utf8 = true,
+    bool lazy_load = true, io_policy policy = io_policy::automatic)
 {
-    auto buffer = buffers::make_shared_file_adapter(path);
-    if (buffer.is_valid())
+    return load(
+        path,
+        [names = std::unordered_set<std::string>(std::cbegin(variables), std::cend(variables))](
+            const std::string& name) { return names.contains(name); },
+        iso_8859_1_to_utf8, lazy_load, policy);
+}
+
+/* Only loads variables whose whole name matches pattern, see load(path, selector, ...) */
+[[nodiscard]] std::optional<CDF> load(const std::string& path, const std::regex& pattern,
+    bool iso_8859_1_to_utf8 = true, bool lazy_load = true, io_policy policy = io_policy::automatic)
+{
+    return load(
+        path, [&pattern](const std::string& name) { return std::regex_match(name, pattern); },
+        iso_8859_1_to_utf8, lazy_load, policy);
+}
+
+/*
+ * Only parses the file structure: variables names, types, shapes and attributes names.
+ * Variables values and attributes values are read and decoded on first access, which makes
+ * this much faster than load when only a few attributes are used (indexing, catalogues...).
+ */
+[[nodiscard]] std::optional<CDF> load_metadata(const std::string& path,
+    bool iso_8859_1_to_utf8 = true, io_policy policy = io_policy::automatic)
+{
+    return load_file(path, iso_8859_1_to_utf8, true, policy, { .lazy_attributes = true });
+}
+
+/*
+ * Opens all files concurrently and concatenates the given variables along records, in paths
+ * order. Final values are allocated once and each file decodes its records straight into its
+ * own slice. Non record varying variables and attributes are taken from the first file.
+ * Returns std::nullopt if a file can't be loaded and throws std::invalid_argument if a
+ * variable is missing or has a different type or record shape in one of the files.
+ */
+[[nodiscard]] std::optional<CDF> load_many(const std::vector<std::string>& paths,
+    const std::vector<std::string>& variables, bool iso_8859_1_to_utf8 = true,
+    io_policy policy = io_policy::automatic)
+{
+    if (std::empty(paths))
+        return std::nullopt;
+    std::vector<std::optional<CDF>> files(std::size(paths));
+    parallel::for_each_index(std::size(paths),
+        [&](std::size_t i)
+        { files[i] = load(paths[i], variables, iso_8859_1_to_utf8, true, policy); });
+    if (std::any_of(
+            std::cbegin(files), std::cend(files), [](const auto& file) { return !file; }))
+        return std::nullopt;
+
+    CDF result;
+    auto& first = *files.front();
+    result.majority = cdf_majority::row;
+    result.distribution_version = first.distribution_version;
+    result.compression = first.compression;
+    result.attributes = std::move(first.attributes);
+    result.lazy_loaded = false;
+    for (const auto& name : variables)
     {
-        return impl_load(std::move(buffer), iso_8859_1_to_utf8, lazy_load);
+        std::vector<const Variable*> parts(std::size(files));
+        for (std::size_t i = 0; i < std::size(files); i++)
+        {
+            auto it = files[i]->variables.find(name);
+            if (it == std::cend(files[i]->variables))
+                throw std::invalid_argument { fmt::format(
+                    "load_many: variable {} is missing from {}", name, paths[i]) };
+            parts[i] = &it->second;
+        }
+        const auto& head = *parts.front();
+        if (head.is_nrv() or std::empty(head.shape()))
+        {
+            result.variables[name] = head;
+            continue;
+        }
+        std::vector<std::size_t> positions(std::size(parts) + 1, 0UL);
+        for (std::size_t i = 0; i < std::size(parts); i++)
+        {
+            const auto& shape = parts[i]->shape();
+            if (parts[i]->type() != head.type() or std::size(shape) != std::size(head.shape())
+                or not std::equal(std::cbegin(shape) + 1, std::cend(shape),
+                    std::cbegin(head.shape()) + 1))
+                throw std::invalid_argument { fmt::format(
+                    "load_many: variable {} type or record shape differs in {}", name,
+                    paths[i]) };
+            positions[i + 1] = positions[i] + parts[i]->len();
+        }
+        const std::size_t record_bytes
+            = std::accumulate(std::cbegin(head.shape()) + 1, std::cend(head.shape()), 1UL,
+                  std::multiplies<std::size_t>())
+            * cdf_type_size(head.type());
+        auto data = new_data_container(positions.back() * record_bytes, head.type());
+        parallel::for_each_index(std::size(parts),
+            [&](std::size_t i)
+            {
+                parts[i]->copy_records_to(
+                    data.bytes_ptr() + positions[i] * record_bytes, 0UL, parts[i]->len());
+            });
+        auto shape = head.shape();
+        shape[0] = static_cast<uint32_t>(positions.back());
+        Variable variable { name, head.number(), std::move(data), std::move(shape),
+            cdf_majority::row, head.is_nrv(), head.compression_type() };
+        variable.attributes = head.attributes;
+        result.variables[name] = std::move(variable);
     }
-    return std::nullopt;
+    return result;
+}
+
+#ifdef USE_MMAP
+/*
+ * Same as load(path, ...) but variable values are fetched with pread and read-ahead hints
+ * instead of page faults on the mapped file, this usually performs better on network
+ * file systems.
+ */
+[[nodiscard]] std::optional<CDF> load_with_reads(
+    const std::string& path, bool iso_8859_1_to_utf8 = true, bool lazy_load = true)
+{
+    return load(path, iso_8859_1_to_utf8, lazy_load, io_policy::pread);
 }
+#endif
 
 [[nodiscard]] std::optional<CDF> load(
     const std::vector<char>& data, bool iso_8859_1_to_utf8 = true, bool lazy_load = false)
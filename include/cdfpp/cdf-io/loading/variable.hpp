@@ -27,13 +27,24 @@
 #include "../common.hpp"
 #include "../decompression.hpp"
 #include "../desc-records.hpp"
+#include "../majority-swap.hpp"
+#include "../parallel.hpp"
+#include "./buffers.hpp"
 #include "./records-loading.hpp"
 #include "cdfpp/cdf-data.hpp"
 #include "cdfpp/no_init_vector.hpp"
 #include "cdfpp/variable.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <optional>
+#include <span>
+#include <vector>
 
 namespace cdf::io::variable
 {
@@ -108,203 +119,652 @@ namespace
             data, offset + sizeof(vvr.header.record_size) + sizeof(vvr.header.record_type), size);
     }
 
-    template <typename cdf_version_tag_t, typename buffer_t>
-    inline void load_vvr_data(buffer_t& stream, std::size_t offset,
-        const cdf_VVR_t<cdf_version_tag_t>& vvr, const std::size_t vvr_records_count,
-        const std::size_t record_size, std::size_t& pos, char* data, std::size_t data_len)
+    using var_block_t = common::var_block_t;
+
+    template <typename cdf_version_tag_t, typename stream_t>
+    void collect_var_blocks(stream_t& stream, const cdf_VXR_t<cdf_version_tag_t>& vxr,
+        std::vector<var_block_t>& blocks)
     {
-        std::size_t vvr_data_size
-            = std::min(static_cast<std::size_t>(vvr_records_count * record_size),
-                static_cast<std::size_t>(data_len - pos));
-        load_vvr_data<cdf_version_tag_t>(stream, offset, vvr_data_size, vvr, data + pos);
-        pos += vvr_data_size;
+        for (auto i = 0UL; i < vxr.NusedEntries; i++)
+        {
+            const std::size_t offset = vxr.Offset.values[i];
+            cdf_DR_header<cdf_version_tag_t, cdf_record_type::UIR> header;
+            load_record(header, stream, offset);
+            const std::size_t header_size = sizeof(header.record_size) + sizeof(header.record_type);
+            switch (header.record_type)
+            {
+                case cdf_record_type::VVR:
+                    blocks.push_back({ static_cast<std::size_t>(vxr.First.values[i]),
+                        static_cast<std::size_t>(vxr.Last.values[i]), offset + header_size,
+                        header.record_size - header_size, false });
+                    break;
+                case cdf_record_type::CVVR:
+                {
+                    // CVVR payload follows rfuA and cSize fields
+                    const std::size_t payload_offset = header_size + sizeof(uint32_t)
+                        + sizeof(cdf_offset_field_t<cdf_version_tag_t>);
+                    blocks.push_back({ static_cast<std::size_t>(vxr.First.values[i]),
+                        static_cast<std::size_t>(vxr.Last.values[i]), offset + payload_offset,
+                        header.record_size - payload_offset, true });
+                    break;
+                }
+                case cdf_record_type::VXR:
+                {
+                    cdf_VXR_t<cdf_version_tag_t> sub_vxr;
+                    load_record(sub_vxr, stream, offset);
+                    collect_var_blocks(stream, sub_vxr, blocks);
+                    while (sub_vxr.VXRnext)
+                    {
+                        load_record(sub_vxr, stream, sub_vxr.VXRnext);
+                        collect_var_blocks(stream, sub_vxr, blocks);
+                    }
+                    break;
+                }
+                default:
+                    throw std::runtime_error {
+                        "Error loading variable data expecting VVR, CVVR or VXR"
+                    };
+            }
+        }
     }
 
-
-    template <typename cdf_version_tag_t, typename buffer_t>
-    inline void load_cvvr_data(const cdf_CVVR_t<cdf_version_tag_t>& cvvr, std::size_t& pos,
-        const cdf_compression_type compression_type, char* data, std::size_t data_len)
+    /* Flattens the VXR tree of a variable into the ordered list of its data blocks */
+    template <typename VDR_t, typename stream_t>
+    std::vector<var_block_t> var_blocks(stream_t& stream, const VDR_t& vdr)
     {
-        pos += decompression::inflate(
-            compression_type, cvvr.data.values, data + pos, data_len - pos);
+        std::vector<var_block_t> blocks;
+        cdf_VXR_t<typename VDR_t::cdf_version_t> vxr;
+        if (vdr.VXRhead != 0 && load_record(vxr, stream, vdr.VXRhead))
+        {
+            collect_var_blocks(stream, vxr, blocks);
+            while (vxr.VXRnext != 0)
+            {
+                if (not load_record(vxr, stream, vxr.VXRnext))
+                    throw std::runtime_error { "Failed to read vxr" };
+                collect_var_blocks(stream, vxr, blocks);
+            }
+        }
+        std::stable_sort(std::begin(blocks), std::end(blocks),
+            [](const var_block_t& a, const var_block_t& b) { return a.first < b.first; });
+        return blocks;
     }
 
-    template <typename cdf_version_tag_t, typename stream_t>
-    void load_var_data(stream_t& stream, char* data, std::size_t data_len, std::size_t& pos,
-        const cdf_VXR_t<cdf_version_tag_t>& vxr, std::size_t record_size,
-        const cdf_compression_type compression_type)
+    template <typename stream_t>
+    inline constexpr bool prefers_reads_v
+        = requires { typename stream_t::buffer_type::prefers_reads; };
+
+    /*
+     * Keeps a window of blocks ahead of the decoders hinted to the buffer so I/O overlaps
+     * with decoding, and lets the buffer drop blocks already decoded (see
+     * mmap_access::drop_behind). This is a no-op for buffers without prefetch support.
+     */
+    template <typename stream_t>
+    struct blocks_prefetcher
     {
-        for (auto i = 0UL; i < vxr.NusedEntries; i++)
+        static constexpr std::ptrdiff_t window = 64L * 1024L * 1024L;
+
+        blocks_prefetcher(stream_t& stream, const var_block_t* blocks, std::size_t count)
+                : p_stream { stream }, p_blocks { blocks }, p_count { count }
         {
-            int record_count = vxr.Last.values[i] - vxr.First.values[i] + 1;
+            advance();
+        }
 
-            if (cdf_mutable_variable_record_t<cdf_version_tag_t> cvvr_or_vvr {};
-                load_mut_record(cvvr_or_vvr, stream, vxr.Offset.values[i]))
+        inline void consumed([[maybe_unused]] const var_block_t& block)
+        {
+            if constexpr (requires { p_stream.release(0UL, 0UL); })
+                p_stream.release(block.offset, block.size);
+            if constexpr (requires { p_stream.prefetch(0UL, 0UL); })
             {
-                using vvr_t = typename decltype(cvvr_or_vvr)::vvr_t;
-                using vxr_t = typename decltype(cvvr_or_vvr)::vxr_t;
-                using cvvr_t = typename decltype(cvvr_or_vvr)::cvvr_t;
+                p_in_flight.fetch_sub(static_cast<std::ptrdiff_t>(block.size));
+                advance();
+            }
+        }
 
-                cvvr_or_vvr.visit(
-                    [&stream, &data, data_len, &pos, record_count, record_size,
-                        offset = vxr.Offset.values[i]](const vvr_t& vvr) -> void
-                    {
-                        load_vvr_data<cdf_version_tag_t, stream_t>(
-                            stream, offset, vvr, record_count, record_size, pos, data, data_len);
-                    },
-                    [&stream, &data, data_len, &pos, record_size, compression_type](
-                        vxr_t vxr) -> void
+    private:
+        inline void advance()
+        {
+            if constexpr (requires { p_stream.prefetch(0UL, 0UL); })
+            {
+                while (p_in_flight.load() < window)
+                {
+                    const auto i = p_next.fetch_add(1UL);
+                    if (i >= p_count)
+                        return;
+                    p_stream.prefetch(p_blocks[i].offset, p_blocks[i].size);
+                    p_in_flight.fetch_add(static_cast<std::ptrdiff_t>(p_blocks[i].size));
+                }
+            }
+        }
+
+        stream_t& p_stream;
+        const var_block_t* p_blocks;
+        std::size_t p_count;
+        std::atomic<std::size_t> p_next { 0UL };
+        std::atomic<std::ptrdiff_t> p_in_flight { 0L };
+    };
+
+    /*
+     * Copies size bytes of block values starting skip bytes after its first record to dest,
+     * CVVRs are inflated, in a temporary buffer when only a part of the block is needed.
+     */
+    template <typename stream_t>
+    void load_block_data(stream_t& stream, const var_block_t& block, std::size_t record_size,
+        std::size_t skip, char* dest, std::size_t size, cdf_compression_type compression_type)
+    {
+        if (not block.compressed)
+        {
+            stream.read(dest, block.offset + skip, size);
+            return;
+        }
+        auto inflate = [&](const auto& input)
+        {
+            const std::size_t block_size = block.records_count() * record_size;
+            if (skip == 0 and size == block_size)
+            {
+                decompression::inflate(compression_type, input, dest, size);
+            }
+            else
+            {
+                no_init_vector<char> buffer(block_size);
+                decompression::inflate(compression_type, input, buffer.data(), block_size);
+                std::memcpy(dest, buffer.data() + skip, size);
+            }
+        };
+        if constexpr (requires { stream.view(0UL); } and not prefers_reads_v<stream_t>)
+        {
+            inflate(std::span<const char> { stream.view(block.offset), block.size });
+        }
+        else
+        {
+            no_init_vector<char> input(block.size);
+            stream.read(input.data(), block.offset, block.size);
+            inflate(input);
+        }
+    }
+
+    /*
+     * Each block lands in its own slice of the output buffer so blocks can be decoded
+     * concurrently, this only pays off when blocks have to be inflated.
+     */
+    inline std::size_t decoding_threads(cdf_compression_type compression_type) noexcept
+    {
+        if (compression_type == cdf_compression_type::no_compression)
+            return 1UL;
+        return parallel::max_threads();
+    }
+
+    /*
+     * Byte swaps and transposes to row major the records of a block right after it was read or
+     * inflated, while it is still in cache, instead of doing it in two more passes over the
+     * whole variable (load_values and majority::swap). Strings are left to load_values since
+     * their latin1 to utf8 conversion may change their size.
+     */
+    struct block_decoder_t
+    {
+        CDF_Types type;
+        cdf_encoding encoding;
+        /* variable shape, records first */
+        no_init_vector<uint32_t> shape;
+        std::size_t record_size;
+        bool column_major;
+
+        [[nodiscard]] static std::optional<block_decoder_t> make(CDF_Types type,
+            cdf_encoding encoding, const no_init_vector<uint32_t>& shape, std::size_t record_size,
+            cdf_majority majority)
+        {
+            if (type == CDF_Types::CDF_NONE or type == CDF_Types::CDF_CHAR
+                or type == CDF_Types::CDF_UCHAR or record_size == 0)
+                return std::nullopt;
+            return block_decoder_t { type, encoding, shape, record_size,
+                majority == cdf_majority::column and std::size(shape) > 2 };
+        }
+
+        inline void operator()(char* values, std::size_t bytes) const
+        {
+            [[maybe_unused]] const bool decoded
+                = load_values<false>(values, bytes, type, encoding);
+            if (column_major)
+            {
+                cdf_type_dispatch(type,
+                    [&]<CDF_Types t>()
                     {
-                        load_var_data<cdf_version_tag_t, stream_t>(
-                            stream, data, data_len, pos, vxr, record_size, compression_type);
-                        while (vxr.VXRnext)
-                        {
-                            load_record(vxr, stream, vxr.VXRnext);
-                            load_var_data<cdf_version_tag_t, stream_t>(
-                                stream, data, data_len, pos, vxr, record_size, compression_type);
-                        }
-                    },
-                    [&stream, &data, data_len, &pos, record_count, record_size, compression_type](
-                        const cvvr_t& cvvr) -> void {
-                        load_cvvr_data<cdf_version_tag_t, stream_t>(
-                            cvvr, pos, compression_type, data, data_len);
-                    },
-                    [](const std::monostate&) -> void {
-                        throw std::runtime_error {
-                            "Error loading variable data expecting VVR, CVVR or VXR"
-                        };
+                        using value_t = from_cdf_type_t<t>;
+                        auto block_shape = shape;
+                        block_shape[0] = static_cast<uint32_t>(bytes / record_size);
+                        std::span<value_t> block_values { reinterpret_cast<value_t*>(values),
+                            bytes / sizeof(value_t) };
+                        majority::swap<false>(block_values, block_shape);
                     });
             }
         }
+    };
+
+    /* blocks are decoded with decoder when given, see block_decoder_t */
+    template <typename stream_t>
+    data_t load_var_data(stream_t& stream, const std::vector<var_block_t>& blocks,
+        const CDF_Types data_type, const std::size_t record_size, const uint32_t record_count,
+        const cdf_compression_type compression_type,
+        const block_decoder_t* const decoder = nullptr)
+    {
+        const std::size_t data_len
+            = static_cast<std::size_t>(record_count) * static_cast<std::size_t>(record_size);
+        data_t data = new_data_container(data_len, data_type);
+        std::vector<std::size_t> positions(std::size(blocks));
+        std::size_t pos { 0UL };
+        for (auto i = 0UL; i < std::size(blocks); i++)
+        {
+            positions[i] = pos;
+            pos = std::min(data_len, pos + blocks[i].records_count() * record_size);
+        }
+        blocks_prefetcher prefetcher { stream, std::data(blocks), std::size(blocks) };
+        parallel::for_each_index(
+            std::size(blocks),
+            [&](std::size_t i)
+            {
+                const auto size = std::min(
+                    blocks[i].records_count() * record_size, data_len - positions[i]);
+                if (size)
+                {
+                    load_block_data(stream, blocks[i], record_size, 0UL,
+                        data.bytes_ptr() + positions[i], size, compression_type);
+                    if (decoder)
+                        (*decoder)(data.bytes_ptr() + positions[i], size);
+                }
+                prefetcher.consumed(blocks[i]);
+            },
+            decoding_threads(compression_type));
+        return data;
+    }
+
+    /* loads all values of a variable, decoded per block when decoder is set */
+    template <bool iso_8859_1_to_utf8, typename stream_t>
+    data_t load_var_values(stream_t& stream, const std::vector<var_block_t>& blocks,
+        const CDF_Types data_type, const std::size_t record_size, const uint32_t record_count,
+        const cdf_compression_type compression_type, const cdf_encoding encoding,
+        const std::optional<block_decoder_t>& decoder)
+    {
+        if (decoder)
+            return load_var_data(stream, blocks, data_type, record_size, record_count,
+                compression_type, &*decoder);
+        return load_values<iso_8859_1_to_utf8>(
+            load_var_data(stream, blocks, data_type, record_size, record_count, compression_type),
+            encoding);
     }
 
     template <typename VDR_t, typename stream_t>
     data_t load_var_data(stream_t& stream, const VDR_t& vdr, const std::size_t record_size,
         const uint32_t record_count, const cdf_compression_type compression_type)
     {
-        data_t data = new_data_container(
-            static_cast<std::size_t>(record_count) * static_cast<std::size_t>(record_size),
-            vdr.DataType);
-        std::size_t pos { 0UL };
-        cdf_VXR_t<typename VDR_t::cdf_version_t> vxr;
+        return load_var_data(stream, var_blocks(stream, vdr), vdr.DataType, record_size,
+            record_count, compression_type);
+    }
 
-        if (vdr.VXRhead != 0 && load_record(vxr, stream, vdr.VXRhead))
+    /*
+     * Returns values referencing the mapped file instead of a copy when they can be used as
+     * they are stored: one uncompressed block holding all records, host byte order, no
+     * string conversion and suitably aligned.
+     */
+    template <typename stream_t>
+    std::optional<data_t> map_var_data(stream_t& stream, const std::vector<var_block_t>& blocks,
+        const CDF_Types data_type, const std::size_t record_size, const uint32_t record_count,
+        const cdf_compression_type compression_type, const cdf_encoding encoding)
+    {
+        if constexpr (requires { typename stream_t::buffer_type; })
         {
-            load_var_data(stream, data.bytes_ptr(), static_cast<std::size_t>(record_count) * record_size, pos, vxr,
-                record_size, compression_type);
-            if (vxr.VXRnext)
+            if constexpr (std::is_same_v<typename stream_t::buffer_type, buffers::mmap_adapter>)
             {
-                do
-                {
-                    if (load_record(vxr, stream, vxr.VXRnext))
-                    {
-                        load_var_data(stream, data.bytes_ptr(), static_cast<std::size_t>(record_count) * record_size, pos,
-                            vxr, record_size, compression_type);
-                    }
-                    else
-                    {
-                        throw std::runtime_error { "Failed to read vxr" };
-                    }
-                } while (vxr.VXRnext != 0);
+                const std::size_t data_len = static_cast<std::size_t>(record_count) * record_size;
+                if (compression_type != cdf_compression_type::no_compression
+                    or std::size(blocks) != 1 or data_len == 0 or is_string(data_type)
+                    or blocks[0].first != 0 or blocks[0].size < data_len
+                    or (cdf_type_size(data_type) > 1
+                        and endianness::is_big_endian_encoding(encoding)
+                            != std::is_same_v<endianness::host_endianness_t,
+                                endianness::big_endian_t>))
+                    return std::nullopt;
+                const char* values = stream.view(blocks[0].offset);
+                if (reinterpret_cast<std::uintptr_t>(values)
+                        % std::min(cdf_type_size(data_type), alignof(std::max_align_t))
+                    != 0)
+                    return std::nullopt;
+                return data_t { stream.owner(), values, data_len, data_type };
             }
         }
+        return std::nullopt;
+    }
+
+    /*
+     * Loads records [first, last) only, blocks that do not overlap the requested range are
+     * skipped so only the needed VVR bytes are read and only the needed CVVRs are inflated.
+     */
+    template <typename stream_t>
+    void load_var_records(stream_t& stream, const std::vector<var_block_t>& blocks,
+        const std::size_t record_size, const std::size_t first, const std::size_t last,
+        const cdf_compression_type compression_type, char* dest)
+    {
+        if (last <= first)
+            return;
+        const auto begin = std::partition_point(std::cbegin(blocks), std::cend(blocks),
+            [first](const var_block_t& block) { return block.last < first; });
+        const auto end = std::partition_point(begin, std::cend(blocks),
+            [last](const var_block_t& block) { return block.first < last; });
+        const auto count = static_cast<std::size_t>(std::distance(begin, end));
+        blocks_prefetcher prefetcher { stream, std::to_address(begin), count };
+        parallel::for_each_index(
+            count,
+            [&](std::size_t i)
+            {
+                const auto& block = *(begin + static_cast<std::ptrdiff_t>(i));
+                const std::size_t start = std::max(first, block.first);
+                const std::size_t stop = std::min(last, block.last + 1UL);
+                load_block_data(stream, block, record_size, (start - block.first) * record_size,
+                    dest + (start - first) * record_size, (stop - start) * record_size,
+                    compression_type);
+                prefetcher.consumed(block);
+            },
+            decoding_threads(compression_type));
+    }
+
+    template <typename stream_t>
+    data_t load_var_records(stream_t& stream, const std::vector<var_block_t>& blocks,
+        const CDF_Types data_type, const std::size_t record_size, const std::size_t first,
+        const std::size_t last, const cdf_compression_type compression_type)
+    {
+        data_t data = new_data_container((last - first) * record_size, data_type);
+        load_var_records(
+            stream, blocks, record_size, first, last, compression_type, data.bytes_ptr());
         return data;
     }
 
+    /*
+     * Block index of a lazy variable, built on first access and shared by all copies of its
+     * loader so the VXR tree is walked at most once per variable.
+     */
+    struct var_blocks_cache_t
+    {
+        std::once_flag built;
+        std::vector<var_block_t> blocks;
+        /* walks the VXR tree, empty when blocks are known upfront */
+        std::function<std::vector<var_block_t>()> build;
+    };
 
-    template <bool iso_8859_1_to_utf8, typename stream_t, typename VDR_t>
+    template <bool iso_8859_1_to_utf8, typename stream_t>
     struct defered_variable_loader
     {
-        defered_variable_loader(stream_t stream, cdf_encoding encoding, VDR_t vdr,
-            uint32_t record_count, std::size_t record_size, cdf_compression_type compression)
+        template <typename VDR_t>
+        defered_variable_loader(stream_t stream, cdf_encoding encoding, const VDR_t& vdr,
+            uint32_t record_count, std::size_t record_size, cdf_compression_type compression,
+            const no_init_vector<uint32_t>& shape, cdf_majority majority)
                 : p_stream { stream }
                 , p_encoding { encoding }
-                , p_vdr { vdr }
+                , p_type { vdr.DataType }
                 , p_record_count { record_count }
                 , p_record_size { record_size }
                 , p_compression { compression }
+                , p_map_values { majority == cdf_majority::row }
+                , p_decoder { block_decoder_t::make(
+                      vdr.DataType, encoding, shape, record_size, majority) }
+                , p_blocks { std::make_shared<var_blocks_cache_t>() }
         {
+            p_blocks->build = [stream, vdr]() mutable { return var_blocks(stream, vdr); };
+        }
+
+        /* for variables whose block index is already known (see header-cache.hpp) */
+        defered_variable_loader(stream_t stream, cdf_encoding encoding, CDF_Types type,
+            uint32_t record_count, std::size_t record_size, cdf_compression_type compression,
+            const no_init_vector<uint32_t>& shape, cdf_majority majority,
+            std::vector<var_block_t>&& blocks)
+                : p_stream { stream }
+                , p_encoding { encoding }
+                , p_type { type }
+                , p_record_count { record_count }
+                , p_record_size { record_size }
+                , p_compression { compression }
+                , p_map_values { majority == cdf_majority::row }
+                , p_decoder { block_decoder_t::make(type, encoding, shape, record_size, majority) }
+                , p_blocks { std::make_shared<var_blocks_cache_t>() }
+        {
+            p_blocks->blocks = std::move(blocks);
         }
 
         inline data_t operator()()
         {
+            if (p_map_values)
+            {
+                if (auto values = map_var_data(this->p_stream, blocks(), p_type,
+                        this->p_record_size, this->p_record_count, p_compression, p_encoding))
+                    return std::move(*values);
+            }
+            return load_var_values<iso_8859_1_to_utf8>(this->p_stream, blocks(), p_type,
+                this->p_record_size, this->p_record_count, p_compression, p_encoding, p_decoder);
+        }
+
+        /* operator()() returns row major values, see lazy_data::values_row_major */
+        [[nodiscard]] inline bool values_row_major() const noexcept
+        {
+            return p_decoder and p_decoder->column_major;
+        }
+
+        inline data_t operator()(std::size_t first, std::size_t last)
+        {
+            last = std::min(last, static_cast<std::size_t>(p_record_count));
+            first = std::min(first, last);
             return load_values<iso_8859_1_to_utf8>(
-                load_var_data(this->p_stream, this->p_vdr, this->p_record_size,
-                    this->p_record_count, p_compression),
+                load_var_records(this->p_stream, blocks(), p_type, this->p_record_size,
+                    first, last, p_compression),
                 this->p_encoding);
         }
 
+        /* decodes records [first, last) into dest, see lazy_data::load_records_into */
+        inline bool operator()(char* dest, std::size_t first, std::size_t last)
+        {
+            const auto type = p_type;
+            if (iso_8859_1_to_utf8
+                and (type == CDF_Types::CDF_CHAR or type == CDF_Types::CDF_UCHAR))
+                return false;
+            last = std::min(last, static_cast<std::size_t>(p_record_count));
+            first = std::min(first, last);
+            load_var_records(
+                this->p_stream, blocks(), this->p_record_size, first, last, p_compression, dest);
+            return load_values<iso_8859_1_to_utf8>(
+                dest, (last - first) * this->p_record_size, type, this->p_encoding);
+        }
+
     private:
+        const std::vector<var_block_t>& blocks()
+        {
+            std::call_once(p_blocks->built,
+                [this]()
+                {
+                    if (p_blocks->build)
+                    {
+                        p_blocks->blocks = p_blocks->build();
+                        p_blocks->build = nullptr;
+                    }
+                });
+            return p_blocks->blocks;
+        }
+
         stream_t p_stream;
         cdf_encoding p_encoding;
-        VDR_t p_vdr;
+        CDF_Types p_type;
         uint32_t p_record_count;
         std::size_t p_record_size;
         cdf_compression_type p_compression;
+        bool p_map_values;
+        std::optional<block_decoder_t> p_decoder;
+        std::shared_ptr<var_blocks_cache_t> p_blocks;
     };
 
-    template <cdf_r_z type, typename cdf_version_tag_t, bool iso_8859_1_to_utf8, typename context_t>
-    bool load_all_Vars(context_t& context, common::cdf_repr& cdf, bool lazy_load = false)
+    /* Everything needed to load a variable, gathered from its VDR */
+    template <typename VDR_t>
+    struct var_desc_t
+    {
+        VDR_t vdr;
+        no_init_vector<uint32_t> shape;
+        std::size_t record_size;
+        uint32_t record_count;
+        bool is_nrv;
+        cdf_compression_type compression_type;
+    };
+
+    template <cdf_r_z type, typename context_t>
+    void mark_selected_Vars(context_t& context, common::cdf_repr& repr)
     {
         std::for_each(begin_VDR<type>(context), end_VDR<type>(context),
             [&](const auto& blk)
             {
                 const auto& [offset, vdr] = blk;
+                const auto number = static_cast<std::size_t>(vdr.Num);
+                if (number >= std::size(repr.selected_variables))
+                    repr.selected_variables.resize(number + 1, false);
+                if (common::is_selected(repr, vdr.Name.value))
+                    repr.selected_variables[number] = true;
+            });
+    }
+
+    template <cdf_r_z type, typename cdf_version_tag_t, typename context_t>
+    auto describe_all_Vars(context_t& context, const common::cdf_repr& repr)
+    {
+        using VDR_t = std::decay_t<decltype((*begin_VDR<type>(context)).second)>;
+        std::vector<var_desc_t<VDR_t>> descs;
+        std::for_each(begin_VDR<type>(context), end_VDR<type>(context),
+            [&](const auto& blk)
+            {
+                const auto& [offset, vdr] = blk;
+                if (not common::is_selected(repr, vdr.Name.value))
+                    return;
+                auto shape = get_variable_dimensions<type>(vdr, context);
+                const std::size_t record_size = var_record_size(shape, vdr.DataType);
+                const auto is_nrv = common::is_nrv(vdr);
+                const auto compression_type = [&, &stream = context, &vdr = vdr]()
                 {
-                    auto shape = get_variable_dimensions<type>(vdr, context);
-                    const std::size_t record_size = var_record_size(shape, vdr.DataType);
-                    const auto is_nrv = common::is_nrv(vdr);
-                    const auto compression_type = [&, &stream = context, &vdr = vdr]()
+                    if (common::is_compressed(vdr))
                     {
-                        if (common::is_compressed(vdr))
-                        {
-                            if (cdf_CPR_t<cdf_version_tag_t> CPR;
-                                vdr.CPRorSPRoffset != static_cast<decltype(vdr.CPRorSPRoffset)>(-1)
-                                && load_record(CPR, stream, vdr.CPRorSPRoffset))
-                                return CPR.cType;
-                        }
-                        return cdf_compression_type::no_compression;
-                    }();
-                    const uint32_t record_count = [is_nrv, MaxRec = vdr.MaxRec]() -> uint32_t
+                        if (cdf_CPR_t<cdf_version_tag_t> CPR;
+                            vdr.CPRorSPRoffset != static_cast<decltype(vdr.CPRorSPRoffset)>(-1)
+                            && load_record(CPR, stream, vdr.CPRorSPRoffset))
+                            return CPR.cType;
+                    }
+                    return cdf_compression_type::no_compression;
+                }();
+                const uint32_t record_count = [is_nrv, MaxRec = vdr.MaxRec]() -> uint32_t
+                {
+                    if (is_nrv and MaxRec != -1)
+                        return 1;
+                    else
+                    {
+                        return static_cast<uint32_t>(MaxRec) + 1U;
+                    }
+                }();
+                /*if ((vdr.DataType != CDF_Types::CDF_CHAR
+                        and vdr.DataType != CDF_Types::CDF_UCHAR)
+                    or !common::is_nrv(vdr))
+                {*/
+                shape.insert(std::cbegin(shape), record_count);
+                /*}*/
+                descs.push_back(
+                    { vdr, std::move(shape), record_size, record_count, is_nrv, compression_type });
+            });
+        return descs;
+    }
+
+    template <cdf_r_z type, typename cdf_version_tag_t, bool iso_8859_1_to_utf8, typename context_t>
+    bool load_all_Vars(context_t& context, common::cdf_repr& cdf, bool lazy_load = false)
+    {
+        auto descs = describe_all_Vars<type, cdf_version_tag_t>(context, cdf);
+        if (lazy_load)
+        {
+            for (auto& desc : descs)
+            {
+                using loader_t
+                    = defered_variable_loader<iso_8859_1_to_utf8, decltype(context.buffer)>;
+                auto loader = [&]()
+                {
+                    if (cdf.layout)
                     {
-                        if (is_nrv and MaxRec != -1)
-                            return 1;
-                        else
+                        auto blocks = var_blocks(context.buffer, desc.vdr);
+                        cdf.layout->var_blocks[desc.vdr.Name.value] = blocks;
+                        return loader_t { context.buffer, context.encoding(), desc.vdr.DataType,
+                            desc.record_count, desc.record_size, desc.compression_type,
+                            desc.shape, cdf.majority, std::move(blocks) };
+                    }
+                    return loader_t { context.buffer, context.encoding(), desc.vdr,
+                        desc.record_count, desc.record_size, desc.compression_type, desc.shape,
+                        cdf.majority };
+                }();
+                common::add_lazy_variable(cdf, desc.vdr.Name.value, desc.vdr.Num,
+                    lazy_data { loader, loader, loader, desc.vdr.DataType,
+                        loader.values_row_major() },
+                    std::move(desc.shape), desc.is_nrv, desc.compression_type);
+            }
+        }
+        else
+        {
+            /*
+             * Variables are decoded (read, inflated, byte swapped and transposed) concurrently,
+             * then inserted in file order so the resulting CDF does not depend on scheduling.
+             */
+            std::vector<Variable> variables(std::size(descs));
+            parallel::for_each_index(std::size(descs),
+                [&](std::size_t i)
+                {
+                    auto& desc = descs[i];
+                    const auto blocks = var_blocks(context.buffer, desc.vdr);
+                    const auto decoder = block_decoder_t::make(desc.vdr.DataType,
+                        context.encoding(), desc.shape, desc.record_size, cdf.majority);
+                    auto values = [&]()
+                    {
+                        if (cdf.majority == cdf_majority::row)
                         {
-                            return static_cast<uint32_t>(MaxRec) + 1U;
+                            if (auto mapped = map_var_data(context.buffer, blocks,
+                                    desc.vdr.DataType, desc.record_size, desc.record_count,
+                                    desc.compression_type, context.encoding()))
+                                return std::move(*mapped);
                         }
+                        return load_var_values<iso_8859_1_to_utf8>(context.buffer, blocks,
+                            desc.vdr.DataType, desc.record_size, desc.record_count,
+                            desc.compression_type, context.encoding(), decoder);
                     }();
-                    /*if ((vdr.DataType != CDF_Types::CDF_CHAR
-                            and vdr.DataType != CDF_Types::CDF_UCHAR)
-                        or !common::is_nrv(vdr))
-                    {*/
-                    shape.insert(std::cbegin(shape), record_count);
-                    /*}*/
-                    if (lazy_load)
+                    if (decoder and decoder->column_major)
                     {
-                        common::add_lazy_variable(cdf, vdr.Name.value, vdr.Num,
-                            lazy_data { defered_variable_loader<iso_8859_1_to_utf8,
-                                            decltype(context.buffer), decltype(vdr)> {
-                                            context.buffer, context.encoding(), vdr, record_count,
-                                            record_size, compression_type },
-                                vdr.DataType },
-                            std::move(shape), is_nrv, compression_type);
+                        // already transposed, set_data skips the constructor majority swap
+                        variables[i] = Variable { desc.vdr.Name.value,
+                            static_cast<std::size_t>(desc.vdr.Num), Variable::var_data_t {},
+                            Variable::shape_t {}, cdf.majority, desc.is_nrv,
+                            desc.compression_type };
+                        variables[i].set_data(std::move(values), std::move(desc.shape));
                     }
                     else
-                    {
-                        common::add_variable(cdf, vdr.Name.value, vdr.Num,
-                            load_values<iso_8859_1_to_utf8>(
-                                load_var_data(context.buffer, vdr, record_size, record_count,
-                                    compression_type),
-                                context.encoding()),
-                            std::move(shape), is_nrv, compression_type);
-                    }
-                }
-            });
+                        variables[i] = Variable { desc.vdr.Name.value,
+                            static_cast<std::size_t>(desc.vdr.Num), std::move(values),
+                            std::move(desc.shape), cdf.majority, desc.is_nrv,
+                            desc.compression_type };
+                });
+            for (auto& variable : variables)
+            {
+                common::add_variable(cdf, std::move(variable));
+            }
+        }
         return true;
     }
 }
 
+/*
+ * When a selector is set, marks which variable numbers are selected so attributes entries
+ * of the other variables can be skipped, must run before attributes are loaded.
+ */
+template <typename context_t>
+void select(context_t& context, cdf::io::common::cdf_repr& cdf)
+{
+    if (cdf.selector)
+    {
+        cdf.selected_variables.assign(std::size(cdf.var_attributes), false);
+        mark_selected_Vars<cdf_r_z::r>(context, cdf);
+        mark_selected_Vars<cdf_r_z::z>(context, cdf);
+    }
+}
+
 template <typename cdf_version_tag_t, bool iso_8859_1_to_utf8, typename context_t>
 bool load_all(context_t& context, cdf::io::common::cdf_repr& cdf, bool lazy_load = false)
 {
@@ -27,10 +27,12 @@
 #include "../cdf-data.hpp"
 #include "../cdf-debug.hpp"
 #include "../no_init_vector.hpp"
+#include "./parallel.hpp"
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <numeric>
+#include <tuple>
 #include <variant>
 #include <vector>
 
@@ -132,11 +134,106 @@ namespace _private
 
 }
 
+namespace _private
+{
+    template <typename T>
+    inline void _transpose(const T* const src, std::size_t src_stride, T* const dst,
+        std::size_t dst_stride, std::size_t rows, std::size_t cols)
+    {
+        for (auto c = 0UL; c < cols; c++)
+        {
+            T* const d = dst + c * dst_stride;
+            const T* const s = src + c;
+            for (auto r = 0UL; r < rows; r++)
+                d[r] = s[r * src_stride];
+        }
+    }
+
+    /*
+     * dst[c * dst_stride + r] = src[r * src_stride + c] for r < rows and c < cols. Writes are
+     * contiguous, matrices that don't fit in L1 are split in tiles so strided reads do not
+     * keep evicting the lines being written.
+     */
+    template <typename T>
+    void transpose_tiled(const T* const src, std::size_t src_stride, T* const dst,
+        std::size_t dst_stride, std::size_t rows, std::size_t cols)
+    {
+        constexpr std::size_t tile = 16;
+        if (rows * cols * sizeof(T) <= 16384)
+            return _transpose(src, src_stride, dst, dst_stride, rows, cols);
+        for (auto col_tile = 0UL; col_tile < cols; col_tile += tile)
+        {
+            for (auto row_tile = 0UL; row_tile < rows; row_tile += tile)
+            {
+                _transpose(src + row_tile * src_stride + col_tile, src_stride,
+                    dst + col_tile * dst_stride + row_tile, dst_stride,
+                    std::min(tile, rows - row_tile), std::min(tile, cols - col_tile));
+            }
+        }
+    }
+
+    /*
+     * Reverses the dimensions order of a (d1, d2[, d3]) record: element (i1, i2, i3) is at
+     * i1 + d1 * (i2 + d2 * i3) in src and at (i1 * d2 + i2) * d3 + i3 in dst.
+     */
+    template <typename T>
+    void transpose_record(const T* const src, T* const dst, const std::vector<std::size_t>& dims)
+    {
+        if (std::size(dims) == 2)
+        {
+            transpose_tiled(src, dims[0], dst, dims[1], dims[1], dims[0]);
+        }
+        else
+        {
+            const auto [d1, d2, d3] = std::tuple { dims[0], dims[1], dims[2] };
+            for (auto i2 = 0UL; i2 < d2; i2++)
+                transpose_tiled(src + d1 * i2, d1 * d2, dst + d3 * i2, d2 * d3, d3, d1);
+        }
+    }
+
+    /* records are transposed by chunks of about 1MB, spread over parallel::max_threads() */
+    template <typename function_t>
+    void for_each_records_chunk(
+        std::size_t records_count, std::size_t bytes_per_record, function_t&& function)
+    {
+        const auto chunk = std::max(std::size_t { 1 },
+            (std::size_t { 1 } << 20) / std::max(std::size_t { 1 }, bytes_per_record));
+        io::parallel::for_each_index((records_count + chunk - 1) / chunk,
+            [&](std::size_t i)
+            { function(i * chunk, std::min(records_count, (i + 1) * chunk)); });
+    }
+}
+
 template <bool is_string, typename shape_t, typename data_t>
 void swap(data_t& data, const shape_t& shape)
 {
+    using value_t = typename data_t::value_type;
     const auto dimensions = std::size(shape);
     // Basically a variable with shape=2 is a variable with 1D records
+    if constexpr (not is_string)
+    {
+        const std::vector<std::size_t> dims(std::cbegin(shape) + 1, std::cend(shape));
+        const auto elements_per_record = std::accumulate(
+            std::cbegin(dims), std::cend(dims), 1UL, std::multiplies<std::size_t>());
+        // the access pattern is cheaper for tiny records (a few elements per row)
+        if ((dimensions == 3 or dimensions == 4) and elements_per_record >= 64)
+        {
+            const std::size_t records_count = static_cast<std::size_t>(shape[0]);
+            _private::for_each_records_chunk(records_count, elements_per_record * sizeof(value_t),
+                [&](std::size_t first, std::size_t last)
+                {
+                    no_init_vector<value_t> temporary_record(elements_per_record);
+                    for (auto record = first; record < last; record++)
+                    {
+                        auto* const values = data.data() + record * elements_per_record;
+                        _private::transpose_record(values, temporary_record.data(), dims);
+                        std::memcpy(values, temporary_record.data(),
+                            elements_per_record * sizeof(value_t));
+                    }
+                });
+            return;
+        }
+    }
     if ((dimensions > 2 && !is_string) or (is_string and dimensions > 3))
     {
         const std::size_t records_count = is_string ? 1 : shape[0];
@@ -144,31 +241,33 @@ void swap(data_t& data, const shape_t& shape)
             std::rbegin(shape) + (is_string ? 1 : 0), std::crend(shape) - (is_string ? 0 : 1));
         const auto access_patern = _private::generate_access_pattern(record_shape);
 
-        std::vector<typename data_t::value_type> temporary_record(
-            std::size(access_patern) * (is_string ? shape.back() : 1));
-
-
         const auto elements_per_record = std::size(access_patern);
         const auto bytes_per_record = elements_per_record
-            * (is_string ? shape.back() : sizeof(typename data_t::value_type));
-        auto offset = 0UL;
-        for (auto record = 0UL; record < records_count; record++)
-        {
-            for (const auto& swap_pair : access_patern)
+            * (is_string ? shape.back() : sizeof(value_t));
+        _private::for_each_records_chunk(records_count, bytes_per_record,
+            [&](std::size_t first, std::size_t last)
             {
-                if constexpr (is_string)
+                std::vector<value_t> temporary_record(
+                    std::size(access_patern) * (is_string ? shape.back() : 1));
+                for (auto record = first; record < last; record++)
                 {
-                    std::memcpy(temporary_record.data() + (swap_pair.src * shape.back()),
-                        data.data() + offset + (swap_pair.dest * shape.back()), shape.back());
+                    const auto offset = record * elements_per_record;
+                    for (const auto& swap_pair : access_patern)
+                    {
+                        if constexpr (is_string)
+                        {
+                            std::memcpy(temporary_record.data() + (swap_pair.src * shape.back()),
+                                data.data() + offset + (swap_pair.dest * shape.back()),
+                                shape.back());
+                        }
+                        else
+                        {
+                            temporary_record[swap_pair.src] = data[offset + swap_pair.dest];
+                        }
+                    }
+                    std::memcpy(data.data() + offset, temporary_record.data(), bytes_per_record);
                 }
-                else
-                {
-                    temporary_record[swap_pair.src] = data[offset + swap_pair.dest];
-                }
-            }
-            std::memcpy(data.data() + offset, temporary_record.data(), bytes_per_record);
-            offset += elements_per_record;
-        }
+            });
     }
 }
 
@@ -0,0 +1,125 @@
+/*------------------------------------------------------------------------------
+-- The MIT License (MIT)
+--
+-- Copyright © 2024, Laboratory of Plasma Physics- CNRS
+--
+-- Permission is hereby granted, free of charge, to any person obtaining a copy
+-- of this software and associated documentation files (the “Software”), to deal
+-- in the Software without restriction, including without limitation the rights
+-- to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+-- of the Software, and to permit persons to whom the Software is furnished to do
+-- so, subject to the following conditions:
+--
+-- The above copyright notice and this permission notice shall be included in all
+-- copies or substantial portions of the Software.
+--
+-- THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+-- INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+-- PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+-- HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+-- OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+-- SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+-------------------------------------------------------------------------------*/
+/*-- Author : Alexis Jeandet
+-- Mail : alexis.jeandet@member.fsf.org
+----------------------------------------------------------------------------*/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cdf::io::parallel
+{
+
+namespace _details
+{
+    inline std::atomic<std::size_t>& max_threads()
+    {
+        static std::atomic<std::size_t> value { 1UL };
+        return value;
+    }
+
+    /* set while running inside a parallel region so nested regions run serially */
+    inline bool& in_parallel_region()
+    {
+        static thread_local bool value = false;
+        return value;
+    }
+
+    struct parallel_region_guard
+    {
+        bool previous;
+        parallel_region_guard() : previous { in_parallel_region() } { in_parallel_region() = true; }
+        ~parallel_region_guard() { in_parallel_region() = previous; }
+    };
+}
+
+/*
+ * Maximum number of threads used to decode a file or compress variables while saving one,
+ * 1 (the default) keeps everything on the calling thread, 0 means one thread per hardware core.
+ */
+inline void set_max_threads(std::size_t count) noexcept
+{
+    if (count == 0)
+        count = std::max(1U, std::thread::hardware_concurrency());
+    _details::max_threads().store(count, std::memory_order_relaxed);
+}
+
+[[nodiscard]] inline std::size_t max_threads() noexcept
+{
+    return _details::max_threads().load(std::memory_order_relaxed);
+}
+
+/*
+ * Calls function(i) for each i in [0, count), spreading calls over at most threads threads
+ * (the calling thread included). Iterations are picked dynamically so uneven work (blocks
+ * with different compression ratios for example) balances well. The first exception thrown
+ * is rethrown on the calling thread once all workers are done.
+ */
+template <typename function_t>
+void for_each_index(std::size_t count, function_t&& function, std::size_t threads = max_threads())
+{
+    threads = std::min(threads, count);
+    if (threads <= 1 or _details::in_parallel_region())
+    {
+        for (auto i = 0UL; i < count; i++)
+            function(i);
+        return;
+    }
+    std::atomic<std::size_t> next { 0UL };
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&]()
+    {
+        _details::parallel_region_guard guard;
+        for (auto i = next.fetch_add(1UL); i < count; i = next.fetch_add(1UL))
+        {
+            try
+            {
+                function(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock { error_mutex };
+                if (not error)
+                    error = std::current_exception();
+                next.store(count);
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (auto i = 1UL; i < threads; i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers)
+        w.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace cdf::io::parallel
@@ -24,8 +24,10 @@
 -- Mail : alexis.jeandet@member.fsf.org
 ----------------------------------------------------------------------------*/
 #pragma once
+#include "./endianness.hpp"
 #include "cdfpp/no_init_vector.hpp"
 #include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <cstring>
 #include <vector>
@@ -34,7 +36,67 @@ namespace cdf::io::rle
 {
 namespace _internal
 {
+    inline constexpr uint64_t low_bits = 0x0101010101010101ULL;
+    inline constexpr uint64_t high_bits = 0x8080808080808080ULL;
 
+    /* words are loaded little endian so that the lowest address byte is the least significant */
+    [[nodiscard]] inline uint64_t load_word(const char* data)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big)
+            return endianness::byte_swap(word);
+        return word;
+    }
+
+    /* index of the first byte of word flagged in mask */
+    [[nodiscard]] inline std::size_t first_flagged_byte(uint64_t mask)
+    {
+        return static_cast<std::size_t>(std::countr_zero(mask)) / 8;
+    }
+
+    /* flags zero bytes of word, only the first flagged byte is exact */
+    [[nodiscard]] inline uint64_t has_zero(uint64_t word)
+    {
+        return (word - low_bits) & ~word & high_bits;
+    }
+
+    /*
+     * RLE is used on sparse counters where literal runs are mostly short, the first bytes are
+     * checked a word at a time and only longer runs go through memchr, which libc implementations
+     * vectorize. Both are much faster than the former branch per byte.
+     */
+    [[nodiscard]] inline const char* find_zero(const char* begin, const char* end)
+    {
+        for (int i = 0; i < 2 and begin + sizeof(uint64_t) <= end; i++)
+        {
+            if (const auto zeros = has_zero(load_word(begin)); zeros != 0)
+                return begin + first_flagged_byte(zeros);
+            begin += sizeof(uint64_t);
+        }
+        if (auto zero = static_cast<const char*>(std::memchr(begin, 0, end - begin)))
+            return zero;
+        return end;
+    }
+
+    [[nodiscard]] inline const char* skip_zeros(const char* begin, const char* end)
+    {
+        while (begin + sizeof(uint64_t) <= end)
+        {
+            if (const auto word = load_word(begin); word != 0)
+                return begin + first_flagged_byte(word);
+            begin += sizeof(uint64_t);
+        }
+        while (begin != end and *begin == 0)
+            begin++;
+        return begin;
+    }
+
+    /* each zero run takes two bytes and is at least followed by one literal */
+    [[nodiscard]] inline std::size_t max_deflated_size(std::size_t size)
+    {
+        return size + size / 2 + 2;
+    }
 }
 
 template <typename T>
@@ -44,79 +106,74 @@ inline std::size_t inflate(const T& input, char* output, const std::size_t outpu
         return 0;
     auto output_cursor = output;
     const auto output_end = output + output_size;
-    auto input_cursor = std::cbegin(input);
-    while (input_cursor != std::cend(input) && output_cursor < output_end)
+    auto input_cursor = std::data(input);
+    const auto input_end = input_cursor + std::size(input);
+    while (input_cursor != input_end && output_cursor < output_end)
     {
-        auto value = *input_cursor;
-        if (value == 0)
+        if (*input_cursor != 0)
         {
-            input_cursor++;
-            if (input_cursor == std::cend(input))
-                break;
-            std::size_t count
-                = std::min(static_cast<std::size_t>(static_cast<unsigned char>(*input_cursor) + 1),
+            // literals runs are copied at once when they span at least a word
+            if (input_end - input_cursor >= 8
+                and not _internal::has_zero(_internal::load_word(input_cursor)))
+            {
+                const auto literals = std::min(
+                    static_cast<std::size_t>(_internal::find_zero(input_cursor, input_end)
+                        - input_cursor),
                     static_cast<std::size_t>(output_end - output_cursor));
-            std::fill_n(output_cursor, count, char { 0 });
-            output_cursor += count;
-        }
-        else
-        {
-            *output_cursor = value;
-            output_cursor++;
+                std::memcpy(output_cursor, input_cursor, literals);
+                output_cursor += literals;
+                input_cursor += literals;
+            }
+            else
+            {
+                *output_cursor++ = *input_cursor++;
+            }
+            continue;
         }
         input_cursor++;
+        if (input_cursor == input_end)
+            break;
+        std::size_t count
+            = std::min(static_cast<std::size_t>(static_cast<unsigned char>(*input_cursor) + 1),
+                static_cast<std::size_t>(output_end - output_cursor));
+        std::memset(output_cursor, 0, count);
+        output_cursor += count;
+        input_cursor++;
     }
     return output_cursor - output;
 }
 
-template <typename T>
-inline void _deflate_copy(const T* input, std::size_t count, no_init_vector<char>& dest)
-{
-    if (count)
-    {
-        const auto sz = std::size(dest);
-        dest.resize(sz + count);
-        std::memcpy(dest.data() + sz, input, count);
-    }
-}
-
 template <typename T>
 inline no_init_vector<char> deflate(const T& input)
 {
-    no_init_vector<char> result;
-    result.reserve(std::size(input));
-    auto input_cursor = std::cbegin(input);
-    auto last_copy_cursor = std::cbegin(input);
-    while (input_cursor != std::cend(input))
+    // the output is sized for the worst case up front and shrunk once done
+    no_init_vector<char> result(_internal::max_deflated_size(std::size(input)));
+    auto output_cursor = result.data();
+    auto input_cursor = reinterpret_cast<const char*>(std::data(input));
+    const auto input_end = input_cursor + std::size(input);
+    while (input_cursor != input_end)
     {
-        auto value = *input_cursor;
-        if (value == 0)
+        const auto zero = _internal::find_zero(input_cursor, input_end);
+        const auto literals = static_cast<std::size_t>(zero - input_cursor);
+        if (literals)
         {
-            _deflate_copy(input.data() + (last_copy_cursor - std::cbegin(input)),
-                input_cursor - last_copy_cursor, result);
-            std::size_t z_count = 0;
-            do
-            {
-                input_cursor++;
-                z_count++;
-            } while (input_cursor != std::cend(input) and *input_cursor == 0);
-            last_copy_cursor = input_cursor;
-            while (z_count > 256)
-            {
-                result.push_back(0);
-                result.push_back(static_cast<char>(255));
-                z_count -= 256;
-            }
-            result.push_back(0);
-            result.push_back(static_cast<char>(z_count - 1));
+            std::memcpy(output_cursor, input_cursor, literals);
+            output_cursor += literals;
         }
-        else
+        if (zero == input_end)
+            break;
+        input_cursor = _internal::skip_zeros(zero, input_end);
+        auto z_count = static_cast<std::size_t>(input_cursor - zero);
+        while (z_count > 256)
         {
-            input_cursor++;
+            *output_cursor++ = 0;
+            *output_cursor++ = static_cast<char>(255);
+            z_count -= 256;
         }
+        *output_cursor++ = 0;
+        *output_cursor++ = static_cast<char>(z_count - 1);
     }
-    _deflate_copy(input.data() + (last_copy_cursor - std::cbegin(input)),
-        input_cursor - last_copy_cursor, result);
+    result.resize(static_cast<std::size_t>(output_cursor - result.data()));
     return result;
 }
 
@@ -0,0 +1,446 @@
+/*------------------------------------------------------------------------------
+-- The MIT License (MIT)
+--
+-- Copyright © 2025, Laboratory of Plasma Physics- CNRS
+--
+-- Permission is hereby granted, free of charge, to any person obtaining a copy
+-- of this software and associated documentation files (the “Software”), to deal
+-- in the Software without restriction, including without limitation the rights
+-- to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+-- of the Software, and to permit persons to whom the Software is furnished to do
+-- so, subject to the following conditions:
+--
+-- The above copyright notice and this permission notice shall be included in all
+-- copies or substantial portions of the Software.
+--
+-- THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+-- INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+-- PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+-- HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+-- OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+-- SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+-------------------------------------------------------------------------------*/
+/*-- Author : Alexis Jeandet
+-- Mail : alexis.jeandet@member.fsf.org
+----------------------------------------------------------------------------*/
+#pragma once
+
+#include "../common.hpp"
+#include "../compression.hpp"
+#include "../desc-records.hpp"
+#include "../endianness.hpp"
+#include "../majority-swap.hpp"
+#include "../parallel.hpp"
+#include "../loading/buffers.hpp"
+#include "../loading/records-loading.hpp"
+#include "../loading/variable.hpp"
+#include "./buffers.hpp"
+#include "./records-saving.hpp"
+#include "cdfpp/cdf-data.hpp"
+#include "cdfpp/cdf-enums.hpp"
+#include "cdfpp/cdf-file.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fmt/core.h>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Appends records to existing variables of a v3 file without rewriting it. New VVRs (CVVRs for
+ * compressed variables) and VXRs are written at the end of the file, then the tail VXR, the VDRs
+ * MaxRec, VXRhead and VXRtail and the GDR eof are updated in place, so the cost only depends on
+ * the appended data.
+ */
+namespace cdf::io
+{
+
+namespace appending
+{
+    using offset_t = cdf_offset_field_t<v3x_tag>;
+
+    /* new VXRs get spare entries so the next appends fill them instead of chaining a VXR each */
+    inline constexpr uint32_t vxr_entries = 16U;
+
+    /* positions of the fields updated in place, from the start of their record */
+    inline constexpr std::size_t header_size = sizeof(offset_t) + sizeof(cdf_record_type);
+    // MaxRec, VXRhead and VXRtail are contiguous, rVDRs and zVDRs share this layout
+    inline constexpr std::size_t vdr_MaxRec_offset
+        = header_size + sizeof(offset_t) + sizeof(CDF_Types);
+    inline constexpr std::size_t gdr_eof_offset = header_size + 3 * sizeof(offset_t);
+    inline constexpr std::size_t gdr_rMaxRec_offset
+        = gdr_eof_offset + sizeof(offset_t) + 2 * sizeof(uint32_t);
+
+    struct block_t
+    {
+        uint32_t first;
+        uint32_t last;
+        offset_t offset;
+    };
+
+    /*
+     * Records allocated after MaxRec in the last VVR, the CDF library allocates VVRs ahead of
+     * the written records, they are filled in place before writing new VVRs.
+     */
+    struct preallocated_t
+    {
+        offset_t offset = 0;
+        std::size_t records = 0UL;
+    };
+
+    /* an existing variable and the records to append to it */
+    struct target_t
+    {
+        const Variable* records;
+        offset_t vdr_offset;
+        cdf_r_z kind;
+        int32_t MaxRec;
+        offset_t VXRhead;
+        offset_t VXRtail;
+        std::optional<cdf_VXR_t<v3x_tag>> tail;
+        cdf_compression_type compression;
+        std::size_t record_size;
+        preallocated_t preallocated = {};
+        std::vector<block_t> blocks = {};
+    };
+
+    /* everything needed from the file, gathered before anything gets written */
+    struct file_state_t
+    {
+        cdf_encoding encoding;
+        cdf_majority majority;
+        offset_t gdr_offset;
+        offset_t eof;
+        int32_t rMaxRec;
+        std::vector<target_t> targets;
+    };
+
+    /* record shapes match when they only differ by dimensions of size 1 */
+    [[nodiscard]] inline bool same_record_shape(
+        const no_init_vector<uint32_t>& file_shape, const Variable::shape_t& shape)
+    {
+        auto non_unit = [](const auto& dims)
+        {
+            no_init_vector<uint32_t> result;
+            std::copy_if(std::cbegin(dims), std::cend(dims), std::back_inserter(result),
+                [](auto d) { return d != 1U; });
+            return result;
+        };
+        if (std::empty(shape))
+            return false;
+        const auto lhs = non_unit(file_shape);
+        const auto rhs = non_unit(Variable::shape_t { std::cbegin(shape) + 1, std::cend(shape) });
+        return std::size(lhs) == std::size(rhs) and std::equal(
+            std::cbegin(lhs), std::cend(lhs), std::cbegin(rhs));
+    }
+
+    template <typename context_t>
+    [[nodiscard]] preallocated_t find_preallocated(context_t& context,
+        const cdf_VXR_t<v3x_tag>& tail, int32_t MaxRec, std::size_t record_size,
+        const std::string& name)
+    {
+        const auto next = static_cast<int64_t>(MaxRec) + 1;
+        for (std::size_t i = 0; i < tail.NusedEntries; i++)
+        {
+            if (static_cast<int64_t>(tail.Last.values[i]) < next)
+                continue;
+            cdf_DR_header<v3x_tag, cdf_record_type::UIR> header;
+            load_record(header, context, tail.Offset.values[i]);
+            if (header.record_type != cdf_record_type::VVR
+                or static_cast<int64_t>(tail.First.values[i]) > next)
+                throw std::invalid_argument { fmt::format(
+                    "append: variable {} has records allocated after MaxRec that can't be "
+                    "written in place",
+                    name) };
+            return { tail.Offset.values[i] + header_size
+                    + (next - tail.First.values[i]) * record_size,
+                static_cast<std::size_t>(tail.Last.values[i] - next + 1) };
+        }
+        return {};
+    }
+
+    template <cdf_r_z type, typename context_t>
+    void find_targets(context_t& context, const CDF& records, file_state_t& state)
+    {
+        std::for_each(begin_VDR<type>(context), end_VDR<type>(context),
+            [&](const auto& blk)
+            {
+                const auto& [offset, vdr] = blk;
+                auto it = records.variables.find(vdr.Name.value);
+                if (it == std::cend(records.variables))
+                    return;
+                const auto& new_records = it->second;
+                const auto file_shape = variable::get_variable_dimensions<type>(vdr, context);
+                if (common::is_nrv(vdr))
+                    throw std::invalid_argument { fmt::format(
+                        "append: variable {} is not record varying", vdr.Name.value) };
+                if (new_records.type() != vdr.DataType
+                    or not same_record_shape(file_shape, new_records.shape()))
+                    throw std::invalid_argument { fmt::format(
+                        "append: variable {} type or record shape differs from the file",
+                        vdr.Name.value) };
+                auto compression = cdf_compression_type::no_compression;
+                if (common::is_compressed(vdr))
+                {
+                    cdf_CPR_t<v3x_tag> cpr;
+                    load_record(cpr, context, vdr.CPRorSPRoffset);
+                    compression = cpr.cType;
+                    if (compression != cdf_compression_type::gzip_compression
+                        and compression != cdf_compression_type::rle_compression)
+                        throw std::invalid_argument { fmt::format(
+                            "append: variable {} compression is not supported", vdr.Name.value) };
+                }
+                const auto record_size = variable::var_record_size(file_shape, vdr.DataType);
+                std::optional<cdf_VXR_t<v3x_tag>> tail;
+                preallocated_t preallocated;
+                if (vdr.VXRtail != 0)
+                {
+                    tail.emplace();
+                    load_record(*tail, context, vdr.VXRtail);
+                    preallocated = find_preallocated(
+                        context, *tail, vdr.MaxRec, record_size, vdr.Name.value);
+                }
+                state.targets.push_back({ &new_records, offset, type, vdr.MaxRec, vdr.VXRhead,
+                    vdr.VXRtail, std::move(tail), compression, record_size, preallocated });
+            });
+    }
+
+    /*
+     * Returns std::nullopt when path isn't an uncompressed v3 file, whole file compression
+     * would need to inflate and rewrite the whole file anyway.
+     */
+    [[nodiscard]] inline std::optional<file_state_t> describe(
+        const std::string& path, const CDF& records)
+    {
+        auto buffer = buffers::make_shared_file_adapter(path);
+        if (not buffer.is_valid())
+            return std::nullopt;
+        uint32_t magic[2];
+        buffer.read(reinterpret_cast<char*>(magic), 0, sizeof(magic));
+        endianness::decode_v<endianness::big_endian_t>(magic, 2);
+        const common::magic_numbers_t magic_numbers { magic[0], magic[1] };
+        if (not common::is_cdf(magic_numbers) or not common::is_v3x(magic_numbers)
+            or common::is_compressed(magic_numbers))
+            return std::nullopt;
+        parsing_context_t<decltype(buffer), v3x_tag> context { std::move(buffer),
+            cdf_compression_type::no_compression };
+        load_record(context.cdr, context.buffer, 8);
+        load_record(context.gdr, context.buffer, context.cdr.GDRoffset);
+        context.majority = common::majority(context.cdr);
+        file_state_t state { context.cdr.Encoding, context.majority, context.cdr.GDRoffset,
+            context.gdr.eof, static_cast<int32_t>(context.gdr.rMaxRec), {} };
+        find_targets<cdf_r_z::r>(context, records, state);
+        find_targets<cdf_r_z::z>(context, records, state);
+        for (const auto& [name, new_records] : records.variables)
+        {
+            if (std::none_of(std::cbegin(state.targets), std::cend(state.targets),
+                    [&new_records](const auto& target) { return target.records == &new_records; }))
+                throw std::invalid_argument { fmt::format(
+                    "append: variable {} is missing from {}", name, path) };
+        }
+        return state;
+    }
+
+    /*
+     * Appended values in the file encoding and majority, std::nullopt when they can be written
+     * as they are.
+     */
+    [[nodiscard]] inline std::optional<data_t> to_file_order(const Variable& records,
+        const char* values, cdf_encoding encoding, cdf_majority majority)
+    {
+        const auto& shape = records.shape();
+        const bool is_str = is_string(records.type());
+        const bool multi_dims = std::size(shape) > (is_str ? 3UL : 2UL);
+        const bool column_major = majority == cdf_majority::column and multi_dims;
+        const bool transpose = column_major != (records.values_column_major() and multi_dims);
+        const bool swap_bytes = not is_str and cdf_type_size(records.type()) > 1
+            and endianness::is_big_endian_encoding(encoding) != host_is_big_endian;
+        if (not transpose and not swap_bytes)
+            return std::nullopt;
+        auto data = new_data_container(records.bytes(), records.type());
+        std::memcpy(data.bytes_ptr(), values, records.bytes());
+        if (transpose and column_major)
+        {
+            // row major records of shape [d1, ..., dn] are column major ones of shape [dn, ..., d1]
+            auto reversed = shape;
+            std::reverse(std::begin(reversed) + 1, std::end(reversed) - (is_str ? 1 : 0));
+            majority::swap(data, reversed);
+        }
+        else if (transpose)
+            majority::swap(data, shape);
+        // byte swapping is its own inverse, decoding from the file encoding also encodes to it
+        if (swap_bytes)
+        {
+            [[maybe_unused]] const bool encoded = load_values<false>(
+                data.bytes_ptr(), data.bytes(), records.type(), encoding);
+        }
+        return data;
+    }
+
+    inline void write_values_records(buffers::file_updater& writer, target_t& target,
+        const char* values, const chunk_policy_t& chunk_policy)
+    {
+        const std::size_t in_place = std::min(target.records->len(), target.preallocated.records);
+        if (in_place != 0)
+        {
+            const auto eof = writer.offset();
+            writer.seek(target.preallocated.offset);
+            writer.write(values, in_place * target.record_size);
+            writer.seek(eof);
+            values += in_place * target.record_size;
+        }
+        const std::size_t records_count = target.records->len() - in_place;
+        const bool compressed = target.compression != cdf_compression_type::no_compression;
+        // same 1GB VVRs limit as saving
+        auto records_per_vvr = std::max(
+            std::size_t { 1 }, (1UL << 30) / std::max(std::size_t { 1 }, target.record_size));
+        if (compressed)
+            records_per_vvr
+                = std::min(records_per_vvr, chunk_policy.records_per_chunk(target.record_size));
+        const auto vvrs_count = (records_count + records_per_vvr - 1) / records_per_vvr;
+        auto records_in = [&](std::size_t index)
+        { return std::min(records_per_vvr, records_count - index * records_per_vvr); };
+        std::vector<record_wrapper<cdf_CVVR_t<v3x_tag>>> cvvrs(compressed ? vvrs_count : 0UL);
+        if (compressed)
+            parallel::for_each_index(vvrs_count,
+                [&](std::size_t index)
+                {
+                    auto& cvvr = cvvrs[index];
+                    cvvr.record.data.values = compression::deflate(target.compression,
+                        std::string_view { values + index * records_per_vvr * target.record_size,
+                            records_in(index) * target.record_size });
+                    cvvr.record.cSize = std::size(cvvr.record.data.values);
+                    update_size(cvvr);
+                });
+        auto first = static_cast<uint32_t>(target.MaxRec + 1 + static_cast<int32_t>(in_place));
+        for (std::size_t index = 0; index < vvrs_count; index++)
+        {
+            const auto count = static_cast<uint32_t>(records_in(index));
+            const offset_t offset = writer.offset();
+            if (compressed)
+            {
+                save_record(cvvrs[index].record, writer);
+                cvvrs[index].record.data.values = {};
+            }
+            else
+            {
+                [[maybe_unused]] const auto end = save_record(cdf_VVR_t<v3x_tag> {},
+                    values + index * records_per_vvr * target.record_size,
+                    count * target.record_size, writer);
+            }
+            target.blocks.push_back({ first, first + count - 1, offset });
+            first += count;
+        }
+        target.MaxRec += static_cast<int32_t>(target.records->len());
+    }
+
+    /*
+     * Fills the spare entries of the tail VXR first, remaining blocks go into a new VXR chained
+     * after it. Links are written after the records they point to, VDR last.
+     */
+    inline void link_values_records(buffers::file_updater& writer, target_t& target)
+    {
+        std::span<const block_t> pending { target.blocks };
+        const auto tail_offset = target.VXRtail;
+        bool tail_changed = false;
+        if (target.tail)
+        {
+            auto& vxr = *target.tail;
+            const auto spare = std::min(
+                static_cast<std::size_t>(vxr.Nentries - vxr.NusedEntries), std::size(pending));
+            for (std::size_t i = 0; i < spare; i++)
+            {
+                vxr.First.values[vxr.NusedEntries + i] = pending[i].first;
+                vxr.Last.values[vxr.NusedEntries + i] = pending[i].last;
+                vxr.Offset.values[vxr.NusedEntries + i] = pending[i].offset;
+            }
+            vxr.NusedEntries += static_cast<uint32_t>(spare);
+            tail_changed = spare != 0;
+            pending = pending.subspan(spare);
+        }
+        if (not std::empty(pending))
+        {
+            const auto entries = std::max(vxr_entries, static_cast<uint32_t>(std::size(pending)));
+            cdf_VXR_t<v3x_tag> vxr { {}, 0, entries, static_cast<uint32_t>(std::size(pending)),
+                {}, {}, {} };
+            vxr.First.values.resize(entries, 0xFFFFFFFF);
+            vxr.Last.values.resize(entries, 0xFFFFFFFF);
+            vxr.Offset.values.resize(entries, static_cast<offset_t>(-1));
+            for (std::size_t i = 0; i < std::size(pending); i++)
+            {
+                vxr.First.values[i] = pending[i].first;
+                vxr.Last.values[i] = pending[i].last;
+                vxr.Offset.values[i] = pending[i].offset;
+            }
+            const offset_t offset = writer.offset();
+            save_record(vxr, writer);
+            if (target.tail)
+            {
+                target.tail->VXRnext = offset;
+                tail_changed = true;
+            }
+            else
+                target.VXRhead = offset;
+            target.VXRtail = offset;
+        }
+        const auto eof = writer.offset();
+        if (tail_changed)
+        {
+            writer.seek(tail_offset);
+            save_record(*target.tail, writer);
+        }
+        writer.seek(target.vdr_offset + vdr_MaxRec_offset);
+        save_field(writer, target.MaxRec);
+        save_field(writer, target.VXRhead);
+        save_field(writer, target.VXRtail);
+        writer.seek(eof);
+    }
+
+} // namespace appending
+
+/*
+ * Appends the records of each variable of records to the variable with the same name in the
+ * CDF file at path, growing it in place, see appending. Compressed variables get their new
+ * records compressed the same way, split according to chunk_policy, and values are converted
+ * to the file encoding and majority.
+ * Returns false when path isn't an uncompressed v3 CDF file or can't be written, throws
+ * std::invalid_argument when a variable is missing from the file, isn't record varying or has
+ * a different type or record shape, in which case the file is left untouched.
+ */
+[[nodiscard]] inline bool append(
+    const std::string& path, const CDF& records, const chunk_policy_t& chunk_policy = {})
+{
+    auto state = appending::describe(path, records);
+    if (not state)
+        return false;
+    buffers::file_updater writer { path };
+    if (not writer.is_open())
+        return false;
+    writer.seek(state->eof);
+    for (auto& target : state->targets)
+    {
+        if (target.records->len() == 0)
+            continue;
+        auto pinned = target.records->budgeted_values();
+        const char* values = pinned ? pinned->bytes_ptr() : target.records->bytes_ptr();
+        const auto converted
+            = appending::to_file_order(*target.records, values, state->encoding, state->majority);
+        appending::write_values_records(
+            writer, target, converted ? converted->bytes_ptr() : values, chunk_policy);
+        appending::link_values_records(writer, target);
+        if (target.kind == cdf_r_z::r)
+            state->rMaxRec = std::max(state->rMaxRec, target.MaxRec);
+    }
+    const auto eof = writer.offset();
+    writer.seek(state->gdr_offset + appending::gdr_eof_offset);
+    save_field(writer, static_cast<appending::offset_t>(eof));
+    writer.seek(state->gdr_offset + appending::gdr_rMaxRec_offset);
+    save_field(writer, state->rMaxRec);
+    writer.flush();
+    return writer.good();
+}
+
+}
@@ -26,13 +26,26 @@
 #pragma once
 
 
+#include "../parallel.hpp"
 #include "cdfpp/no_init_vector.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <numeric>
 #include <optional>
+#include <string>
 #include <utility>
+#include <vector>
+
+#if __has_include(<unistd.h>) && __has_include(<fcntl.h>)
+#include <fcntl.h>
+#include <unistd.h>
+// internal, undefined at the end of this header
+#define CDFPP_USE_PWRITE
+#endif
 
 namespace cdf::io::buffers
 {
@@ -97,6 +110,216 @@ struct file_writer
         return global_offset;
     }
 
+    [[nodiscard]] bool close()
+    {
+        if (not is_open())
+            return false;
+        os.flush();
+        const bool good = os.good();
+        os.close();
+        return good;
+    }
+
+    [[nodiscard]] std::size_t offset() const noexcept { return this->global_offset; }
+};
+
+/* writes into an existing file, at its end or over records that have to be updated in place */
+struct file_updater
+{
+    std::fstream os;
+    std::size_t global_offset;
+    file_updater(const std::string& fname) : global_offset { 0 }
+    {
+        this->os = std::fstream(fname, std::fstream::in | std::fstream::out | std::fstream::binary);
+    }
+    ~file_updater()
+    {
+        if (is_open())
+        {
+            os.flush();
+            os.close();
+        }
+    }
+
+    [[nodiscard]] bool is_open() const noexcept { return os.is_open(); }
+    [[nodiscard]] bool good() const noexcept { return os.good(); }
+
+    void seek(std::size_t offset)
+    {
+        os.seekp(static_cast<std::streamoff>(offset));
+        global_offset = offset;
+    }
+
+    std::size_t write(const char* const data_ptr, std::size_t count)
+    {
+        os.write(data_ptr, count);
+        global_offset += count;
+        return global_offset;
+    }
+
+    std::size_t fill(const char v, std::size_t count)
+    {
+        std::vector<char> values(count, v);
+        os.write(values.data(), count);
+        global_offset += count;
+        return global_offset;
+    }
+
+    void flush() { os.flush(); }
+
     [[nodiscard]] std::size_t offset() const noexcept { return this->global_offset; }
 };
+
+#ifdef CDFPP_USE_PWRITE
+/*
+ * Writes a file whose layout is known up front (see saving::map_records). Small writes (records
+ * fields) are gathered in a buffer written at its offset once a large write comes in, large
+ * writes (values payloads) are only recorded and written by write_deferred, straight from the
+ * caller memory with pwrite, in slices spread over parallel::max_threads() threads.
+ * Callers must keep deferred memory alive until write_deferred or close returns.
+ */
+struct positional_file_writer
+{
+    static constexpr std::size_t defer_threshold = 64UL << 10;
+    static constexpr std::size_t slice_size = 8UL << 20;
+
+    struct span_t
+    {
+        std::size_t offset;
+        const char* data;
+        std::size_t size;
+    };
+
+    int fd;
+    std::size_t global_offset;
+    std::atomic<bool> failed;
+    no_init_vector<char> buffer;
+    std::vector<span_t> deferred;
+
+    positional_file_writer(const std::string& fname) : global_offset { 0 }, failed { false }
+    {
+        this->fd = ::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    positional_file_writer(const positional_file_writer&) = delete;
+    positional_file_writer& operator=(const positional_file_writer&) = delete;
+    // deferred spans may point to released memory when saving threw, they are dropped
+    ~positional_file_writer()
+    {
+        if (is_open())
+            ::close(fd);
+    }
+
+    [[nodiscard]] bool is_open() const noexcept { return fd != -1; }
+    [[nodiscard]] bool good() const noexcept { return is_open() and not failed.load(); }
+
+    /* preallocates the file so concurrent writes don't fragment it, best effort */
+    void reserve([[maybe_unused]] std::size_t size) const noexcept
+    {
+#ifdef __linux__
+        if (is_open() and size != 0)
+            (void)::fallocate(fd, 0, 0, static_cast<off_t>(size));
+#endif
+    }
+
+    std::size_t write(const char* const data_ptr, std::size_t count)
+    {
+        if (count >= defer_threshold)
+        {
+            flush_buffer();
+            deferred.push_back({ global_offset, data_ptr, count });
+        }
+        else
+        {
+            std::memcpy(grow_buffer(count), data_ptr, count);
+        }
+        global_offset += count;
+        return global_offset;
+    }
+
+    std::size_t fill(const char v, std::size_t count)
+    {
+        std::memset(grow_buffer(count), v, count);
+        global_offset += count;
+        return global_offset;
+    }
+
+    void write_deferred()
+    {
+        flush_buffer();
+        std::vector<span_t> slices;
+        for (const auto& span : deferred)
+        {
+            for (auto done = 0UL; done < span.size; done += slice_size)
+                slices.push_back({ span.offset + done, span.data + done,
+                    std::min(slice_size, span.size - done) });
+        }
+        deferred.clear();
+        parallel::for_each_index(std::size(slices),
+            [this, &slices](std::size_t index)
+            {
+                const auto& slice = slices[index];
+                if (not write_at(slice.offset, slice.data, slice.size))
+                    failed.store(true);
+            });
+    }
+
+    [[nodiscard]] bool close()
+    {
+        if (not is_open())
+            return false;
+        write_deferred();
+        if (::close(fd) != 0)
+            failed.store(true);
+        fd = -1;
+        return not failed.load();
+    }
+
+    [[nodiscard]] std::size_t offset() const noexcept { return this->global_offset; }
+
+private:
+    bool write_at(std::size_t offset, const char* data, std::size_t size) const noexcept
+    {
+        while (size != 0)
+        {
+            const auto count = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += count;
+            offset += static_cast<std::size_t>(count);
+            size -= static_cast<std::size_t>(count);
+        }
+        return true;
+    }
+
+    char* grow_buffer(std::size_t count)
+    {
+        if (std::size(buffer) + count > slice_size)
+            flush_buffer();
+        const auto buffered = std::size(buffer);
+        buffer.resize(buffered + count);
+        return buffer.data() + buffered;
+    }
+
+    void flush_buffer()
+    {
+        if (std::size(buffer) != 0)
+        {
+            if (not write_at(global_offset - std::size(buffer), buffer.data(), std::size(buffer)))
+                failed.store(true);
+            buffer.clear();
+        }
+    }
+};
+
+/* writer used when saving to a path */
+using path_writer = positional_file_writer;
+#else
+using path_writer = file_writer;
+#endif
 }
+
+#undef CDFPP_USE_PWRITE
@@ -27,13 +27,16 @@
 
 #include "../compression.hpp"
 #include "../desc-records.hpp"
+#include "../parallel.hpp"
 #include "./records-saving.hpp"
 #include "cdfpp/cdf-enums.hpp"
 #include "cdfpp/cdf-file.hpp"
+#include "cdfpp/memory-budget.hpp"
 #include "cdfpp/no_init_vector.hpp"
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <optional>
 #include <utility>
@@ -185,9 +188,21 @@ namespace saving
         vdr.MaxRec = variable.len() - 1;
     }
 
-    typename variable_ctx::values_records_t make_values_record(const Variable& v,
-        const std::size_t records_in_vvr, const std::size_t record_size,
-        const std::size_t first_record)
+    /* one CVVR payload to compress, see compress_values_records */
+    struct compression_job_t
+    {
+        std::size_t variable;
+        std::size_t values_record;
+        cdf_compression_type compression;
+        const char* values;
+        std::size_t bytes;
+        // keeps budgeted values alive until they are compressed
+        std::shared_ptr<const data_t> pinned;
+    };
+
+    /* CVVRs are only sized once compress_values_records filled them */
+    typename variable_ctx::values_records_t make_values_record(
+        const Variable& v, const std::size_t records_in_vvr, const std::size_t record_size)
     {
         if (v.compression_type() == cdf_compression_type::no_compression)
         {
@@ -197,18 +212,40 @@ namespace saving
         }
         else
         {
-            auto cvvr = record_wrapper<cdf_CVVR_t<v3x_tag>> {};
-            cvvr.record.data.values = compression::deflate(v.compression_type(),
-                std::string_view {
-                    v.bytes_ptr() + first_record * record_size, records_in_vvr * record_size });
-            cvvr.record.cSize = std::size(cvvr.record.data.values);
-            update_size(cvvr);
-            return cvvr;
+            return record_wrapper<cdf_CVVR_t<v3x_tag>> {};
         }
     }
 
+    /*
+     * Compresses every CVVR payload, spread over parallel::max_threads() threads. Each job
+     * only writes its own record so the output is the same whatever the number of threads.
+     */
+    inline void compress_values_records(
+        saving_context& svg_ctx, std::vector<compression_job_t>& jobs)
+    {
+        if (std::empty(jobs))
+            return;
+        parallel::for_each_index(std::size(jobs),
+            [&svg_ctx, &jobs](std::size_t index)
+            {
+                auto& job = jobs[index];
+                auto& cvvr = std::get<record_wrapper<cdf_CVVR_t<v3x_tag>>>(
+                    svg_ctx.body.variables[job.variable].values_records[job.values_record]);
+                cvvr.record.data.values = compression::deflate(
+                    job.compression, std::string_view { job.values, job.bytes });
+                cvvr.record.cSize = std::size(cvvr.record.data.values);
+                update_size(cvvr);
+                job.pinned.reset();
+            });
+        jobs.clear();
+    }
+
     inline void create_variables_records(const CDF& cdf, saving_context& svg_ctx)
     {
+        std::vector<compression_job_t> compression_jobs;
+        // bytes of budgeted values pinned by pending jobs, they are compressed in batches
+        // fitting the memory budget instead of keeping every budgeted variable resident
+        std::size_t pinned_bytes = 0UL;
         for (const auto& [name, variable] : cdf.variables)
         {
             int32_t index = std::size(svg_ctx.body.variables);
@@ -241,32 +278,61 @@ namespace saving
                     .cpr = std::nullopt });
 
             populate_variable_geometry(variable, var_ctx.vdr.record);
+            const auto var_record_size
+                = std::max(std::size_t { 1 },
+                      flat_size(std::cbegin(variable.shape()) + 1, std::cend(variable.shape())))
+                * cdf_type_size(variable.type());
+            // this is an arbitrary decision to limit VVRs to 1GB
+            auto records_per_vvr = std::max(std::size_t { 1 }, (1UL << 30) / var_record_size);
             if (variable.compression_type() != cdf_compression_type::no_compression)
             {
                 var_ctx.cpr = make_cpr(variable.compression_type());
                 var_ctx.vdr.record.Flags |= 1 << 2;
-                var_ctx.vdr.record.BlockingFactor = 0x40;
+                // the blocking factor of a compressed variable is its records count per CVVR
+                records_per_vvr = std::min(
+                    records_per_vvr, svg_ctx.chunk_policy.records_per_chunk(var_record_size));
+                var_ctx.vdr.record.BlockingFactor = static_cast<int32_t>(records_per_vvr);
             }
             update_size(var_ctx.vdr);
             if (variable.len())
             {
                 auto& vxr
                     = var_ctx.vxrs.emplace_back(cdf_VXR_t<v3x_tag> { {}, 0, 0, 0, {}, {}, {} });
-                const auto var_record_size
-                    = std::max(std::size_t { 1 },
-                          flat_size(std::cbegin(variable.shape()) + 1, std::cend(variable.shape())))
-                    * cdf_type_size(variable.type());
                 {
+                    const bool compressed
+                        = variable.compression_type() != cdf_compression_type::no_compression;
+                    // values are loaded here, on the calling thread, before compression jobs run
+                    std::shared_ptr<const data_t> pinned;
+                    const char* values = nullptr;
+                    if (compressed)
+                    {
+                        variable.load_values();
+                        if (variable.values_budgeted())
+                        {
+                            if (pinned_bytes != 0UL
+                                and pinned_bytes + variable.bytes() > memory_budget::budget())
+                            {
+                                compress_values_records(svg_ctx, compression_jobs);
+                                pinned_bytes = 0UL;
+                            }
+                            pinned_bytes += variable.bytes();
+                        }
+                        pinned = variable.budgeted_values();
+                        values = pinned ? pinned->bytes_ptr() : variable.bytes_ptr();
+                    }
                     auto records = variable.len();
                     auto first_record = 0;
                     while (records > 0)
                     {
-                        // this is an arbitrary decision to limit VVRs to 1GB
                         auto records_in_vvr
-                            = std::min(static_cast<std::size_t>((1 << 30) / var_record_size),
-                                static_cast<std::size_t>(records));
-                        var_ctx.values_records.emplace_back(make_values_record(
-                            variable, records_in_vvr, var_record_size, first_record));
+                            = std::min(records_per_vvr, static_cast<std::size_t>(records));
+                        if (compressed)
+                            compression_jobs.push_back({ std::size(svg_ctx.body.variables) - 1,
+                                std::size(var_ctx.values_records), variable.compression_type(),
+                                values + first_record * var_record_size,
+                                records_in_vvr * var_record_size, pinned });
+                        var_ctx.values_records.emplace_back(
+                            make_values_record(variable, records_in_vvr, var_record_size));
                         vxr.record.First.values.push_back(first_record);
                         vxr.record.Last.values.push_back(first_record + records_in_vvr - 1);
                         first_record += records_in_vvr;
@@ -280,6 +346,7 @@ namespace saving
             }
             create_variable_attributes_records(var_ctx, svg_ctx);
         }
+        compress_values_records(svg_ctx, compression_jobs);
     }
 
 
@@ -130,9 +130,30 @@ struct cdf_body
     std::vector<variable_ctx> variables;
 };
 
+/*
+ * How values of compressed variables are split into CVVRs when saving. Each CVVR is inflated as
+ * a whole to read any of its records, smaller ones give cheaper random access and more chunks
+ * to compress or decompress in parallel, larger ones compress slightly better.
+ */
+struct chunk_policy_t
+{
+    /* uncompressed bytes per CVVR, rounded down to whole records (at least one) */
+    std::size_t target_bytes = 4UL << 20;
+    /* records per CVVR, overrides target_bytes when not 0 */
+    std::size_t records = 0UL;
+
+    [[nodiscard]] std::size_t records_per_chunk(std::size_t record_size) const noexcept
+    {
+        if (records != 0UL)
+            return records;
+        return std::max(std::size_t { 1 }, target_bytes / std::max(std::size_t { 1 }, record_size));
+    }
+};
+
 struct saving_context
 {
     cdf_compression_type compression = cdf_compression_type::no_compression;
+    chunk_policy_t chunk_policy;
     common::magic_numbers_t magic;
     std::optional<record_wrapper<cdf_CCR_t<v3x_tag>>> ccr;
     std::optional<record_wrapper<cdf_CPR_t<v3x_tag>>> cpr;
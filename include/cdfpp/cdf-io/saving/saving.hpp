@@ -58,6 +58,21 @@ namespace saving
     }
 
 
+    /* writers like buffers::positional_file_writer only record large writes until flushed */
+    template <typename T>
+    void flush_deferred_writes(T& writer)
+    {
+        if constexpr (requires { writer.write_deferred(); })
+            writer.write_deferred();
+    }
+
+    template <typename T>
+    void reserve(T& writer, std::size_t file_size)
+    {
+        if constexpr (requires { writer.reserve(file_size); })
+            writer.reserve(file_size);
+    }
+
     template <typename T, typename U>
     void write_record(const record_wrapper<T>& r, U&& writer, std::size_t virtual_offset = 0)
     {
@@ -110,7 +125,8 @@ namespace saving
         const std::vector<typename variable_ctx::values_records_t>& values_records, U&& writer,
         std::size_t virtual_offset = 0)
     {
-        const auto* data = variable->bytes_ptr();
+        auto pinned = variable->budgeted_values();
+        const auto* data = pinned ? pinned->bytes_ptr() : variable->bytes_ptr();
         for (auto& values_record : values_records)
         {
             visit(
@@ -126,6 +142,9 @@ namespace saving
                 [&writer, virtual_offset](const record_wrapper<cdf_CVVR_t<v3x_tag>>& cvvr)
                 { write_record(cvvr, writer, virtual_offset); });
         }
+        // budgeted values can be evicted once unpinned
+        if (pinned)
+            flush_deferred_writes(writer);
     }
 
     template <typename T>
@@ -246,35 +265,55 @@ Greenbelt, Maryland 20771 USA
     }
 
 
+    /* files are always written row major, values kept in file order get transposed first */
+    [[nodiscard]] inline bool has_column_major_values(const CDF& cdf)
+    {
+        return std::any_of(std::cbegin(cdf.variables), std::cend(cdf.variables),
+            [](const auto& item) { return item.second.values_column_major(); });
+    }
+
     template <typename T>
-    [[nodiscard]] bool impl_save(const CDF& cdf, T& writer)
+    [[nodiscard]] bool impl_save(const CDF& cdf, T& writer, const chunk_policy_t& chunk_policy)
     {
+        if (has_column_major_values(cdf))
+        {
+            CDF row_major = cdf;
+            for (auto& [name, variable] : row_major.variables)
+                variable.to_row_major();
+            return impl_save(row_major, writer, chunk_policy);
+        }
         saving_context svg_ctx = make_saving_context(cdf);
+        svg_ctx.chunk_policy = chunk_policy;
         create_file_attributes_records(cdf, svg_ctx);
         create_variables_records(cdf, svg_ctx);
         auto eof = map_records(svg_ctx);
         link_records(svg_ctx);
         update_gdr(svg_ctx, eof);
         apply_compression(svg_ctx);
+        reserve(writer, svg_ctx.cpr ? svg_ctx.cpr->offset + svg_ctx.cpr->size : eof);
         write_records(svg_ctx, writer);
+        flush_deferred_writes(writer);
         return true;
     }
 
 } // namespace
 
 
-[[nodiscard]] inline bool save(const CDF& cdf, const std::string& path)
+/* chunk_policy only applies to compressed variables, see chunk_policy_t */
+[[nodiscard]] inline bool save(
+    const CDF& cdf, const std::string& path, const chunk_policy_t& chunk_policy = {})
 {
-    buffers::file_writer writer { path };
-    return saving::impl_save(cdf, writer);
+    buffers::path_writer writer { path };
+    return writer.is_open() and saving::impl_save(cdf, writer, chunk_policy) and writer.close();
 }
 
-[[nodiscard]] inline no_init_vector<char> save(const CDF& cdf)
+[[nodiscard]] inline no_init_vector<char> save(
+    const CDF& cdf, const chunk_policy_t& chunk_policy = {})
 {
     no_init_vector<char> data;
     data.reserve(saving::estimate_size(cdf));
     buffers::vector_writer writer { data };
-    if (saving::impl_save(cdf, writer))
+    if (saving::impl_save(cdf, writer, chunk_policy))
         return data;
     return {};
 }
@@ -36,6 +36,66 @@ namespace cdf::io::zlib
 {
 namespace _internal
 {
+    /*
+     * z_streams are initialized once per thread and reset between blocks, inflateInit2 and
+     * deflateInit2 allocate several KB of state which dominates for small blocks.
+     */
+    struct thread_inflate_stream
+    {
+        z_stream stream {};
+        bool ready = false;
+
+        thread_inflate_stream() { ready = (inflateInit2(&stream, 32 + MAX_WBITS) == Z_OK); }
+        ~thread_inflate_stream()
+        {
+            if (ready)
+                inflateEnd(&stream);
+        }
+
+        z_stream* get()
+        {
+            if (ready and inflateReset(&stream) == Z_OK)
+                return &stream;
+            return nullptr;
+        }
+    };
+
+    struct thread_deflate_stream
+    {
+        z_stream stream {};
+        bool ready = false;
+
+        thread_deflate_stream()
+        {
+            ready = (deflateInit2(
+                         &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 | 16, 6, Z_DEFAULT_STRATEGY)
+                == Z_OK);
+        }
+        ~thread_deflate_stream()
+        {
+            if (ready)
+                deflateEnd(&stream);
+        }
+
+        z_stream* get()
+        {
+            if (ready and deflateReset(&stream) == Z_OK)
+                return &stream;
+            return nullptr;
+        }
+    };
+
+    inline z_stream* thread_inflate_z_stream()
+    {
+        thread_local thread_inflate_stream stream;
+        return stream.get();
+    }
+
+    inline z_stream* thread_deflate_z_stream()
+    {
+        thread_local thread_deflate_stream stream;
+        return stream.get();
+    }
 
     // Taken from:
     //   https://github.com/qpdf/qpdf/blob/master/libqpdf/Pl_Flate.cc
@@ -43,24 +103,18 @@ namespace _internal
     CDF_WARN_UNUSED_RESULT std::size_t impl_inflate(
         const T& input, char* output, const std::size_t output_size)
     {
-
-        z_stream fstream;
-        fstream.zalloc = Z_NULL;
-        fstream.zfree = Z_NULL;
-        fstream.opaque = Z_NULL;
-        fstream.avail_in = std::size(input);
-        fstream.next_in = reinterpret_cast<const Bytef*>(input.data());
-        fstream.avail_out = output_size;
-        fstream.next_out = reinterpret_cast<Bytef*>(output);
-
-        if (Z_OK != inflateInit2(&fstream, 32 + MAX_WBITS))
+        z_stream* fstream = thread_inflate_z_stream();
+        if (fstream == nullptr)
             return 0;
+        fstream->avail_in = std::size(input);
+        fstream->next_in = reinterpret_cast<const Bytef*>(input.data());
+        fstream->avail_out = output_size;
+        fstream->next_out = reinterpret_cast<Bytef*>(output);
 
-        auto ret = inflate(&fstream, Z_FINISH);
-        inflateEnd(&fstream);
+        auto ret = inflate(fstream, Z_FINISH);
 
         if (ret == Z_STREAM_END)
-            return output_size - fstream.avail_out;
+            return output_size - fstream->avail_out;
         else
             return 0;
     }
@@ -68,24 +122,18 @@ namespace _internal
     template <typename T>
     CDF_WARN_UNUSED_RESULT no_init_vector<char> impl_deflate(const T& input)
     {
-        no_init_vector<char> result(std::max(std::size(input), 16 * 1024UL));
-        z_stream fstream;
-        fstream.zalloc = Z_NULL;
-        fstream.zfree = Z_NULL;
-        fstream.opaque = Z_NULL;
-        fstream.avail_in = std::size(input);
-        fstream.next_in = reinterpret_cast<const Bytef*>(input.data());
-        fstream.avail_out = std::size(result);
-        fstream.next_out = reinterpret_cast<Bytef*>(result.data());
-        if (Z_OK
-            != deflateInit2(
-                &fstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 | 16, 6, Z_DEFAULT_STRATEGY))
+        z_stream* fstream = thread_deflate_z_stream();
+        if (fstream == nullptr)
             return {};
-        auto ret = deflate(&fstream, Z_FINISH);
-        deflateEnd(&fstream);
+        no_init_vector<char> result(std::max(std::size(input), 16 * 1024UL));
+        fstream->avail_in = std::size(input);
+        fstream->next_in = reinterpret_cast<const Bytef*>(input.data());
+        fstream->avail_out = std::size(result);
+        fstream->next_out = reinterpret_cast<Bytef*>(result.data());
+        auto ret = deflate(fstream, Z_FINISH);
         if (ret == Z_STREAM_END)
         {
-            result.resize(fstream.total_out);
+            result.resize(fstream->total_out);
             result.shrink_to_fit();
             return result;
         }
@@ -27,6 +27,7 @@
 #include "../cdf-debug.hpp"
 #include "cdfpp/no_init_vector.hpp"
 #include <cstddef>
+#include <memory>
 #include <vector>
 #include <zstd.h>
 
@@ -35,12 +36,38 @@ namespace cdf::io::zstd
 {
 namespace _internal
 {
+    struct dctx_deleter
+    {
+        void operator()(ZSTD_DCtx* ctx) const noexcept { ZSTD_freeDCtx(ctx); }
+    };
+
+    struct cctx_deleter
+    {
+        void operator()(ZSTD_CCtx* ctx) const noexcept { ZSTD_freeCCtx(ctx); }
+    };
+
+    /* contexts are kept per thread, ZSTD_decompress/ZSTD_compress create one on each call */
+    inline ZSTD_DCtx* thread_dctx()
+    {
+        thread_local std::unique_ptr<ZSTD_DCtx, dctx_deleter> ctx { ZSTD_createDCtx() };
+        return ctx.get();
+    }
+
+    inline ZSTD_CCtx* thread_cctx()
+    {
+        thread_local std::unique_ptr<ZSTD_CCtx, cctx_deleter> ctx { ZSTD_createCCtx() };
+        return ctx.get();
+    }
 
     template <typename T>
     CDF_WARN_UNUSED_RESULT std::size_t impl_inflate(
         const T& input, char* output, const std::size_t output_size)
     {
-        const auto ret = ZSTD_decompress(output, output_size, input.data(), std::size(input));
+        auto ctx = thread_dctx();
+        if (!ctx)
+            return 0;
+        const auto ret
+            = ZSTD_decompressDCtx(ctx, output, output_size, input.data(), std::size(input));
 
         if (!ZSTD_isError(ret))
             return ret;
@@ -51,9 +78,12 @@ namespace _internal
     template <typename T>
     CDF_WARN_UNUSED_RESULT no_init_vector<char> impl_deflate(const T& input)
     {
+        auto ctx = thread_cctx();
+        if (!ctx)
+            return {};
         no_init_vector<char> result(ZSTD_compressBound(std::size(input)));
-        const auto ret
-            = ZSTD_compress(result.data(), result.size(), input.data(), std::size(input), 1);
+        const auto ret = ZSTD_compressCCtx(
+            ctx, result.data(), result.size(), input.data(), std::size(input), 1);
         if (!ZSTD_isError(ret))
         {
             result.resize(ret);
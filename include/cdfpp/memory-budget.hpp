@@ -0,0 +1,268 @@
+/*------------------------------------------------------------------------------
+-- The MIT License (MIT)
+--
+-- Copyright © 2024, Laboratory of Plasma Physics- CNRS
+--
+-- Permission is hereby granted, free of charge, to any person obtaining a copy
+-- of this software and associated documentation files (the “Software”), to deal
+-- in the Software without restriction, including without limitation the rights
+-- to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+-- of the Software, and to permit persons to whom the Software is furnished to do
+-- so, subject to the following conditions:
+--
+-- The above copyright notice and this permission notice shall be included in all
+-- copies or substantial portions of the Software.
+--
+-- THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+-- INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+-- PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+-- HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+-- OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+-- SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+-------------------------------------------------------------------------------*/
+/*-- Author : Alexis Jeandet
+-- Mail : alexis.jeandet@member.fsf.org
+----------------------------------------------------------------------------*/
+#pragma once
+#include "cdf-data.hpp"
+#include "cdf-enums.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+
+/*
+ * Process wide memory budget for lazily loaded variables values.
+ * When a budget is set, values a lazy variable loads on the heap are tracked in a LRU list,
+ * once their total size exceeds the budget the least recently accessed ones are released and
+ * their variables go back to the lazy state, they are loaded again from the file on the next
+ * access.
+ * Values mapped from the file are not tracked since they only use page cache.
+ * Evicted values still referenced elsewhere (a pinned variable, a numpy array, ...) stay alive
+ * until released and are reused instead of being loaded again when accessed before that.
+ */
+namespace cdf::memory_budget
+{
+
+struct usage_t
+{
+    /* 0 when there is no budget */
+    std::size_t budget = 0UL;
+    std::size_t resident_bytes = 0UL;
+    std::size_t resident_count = 0UL;
+    /* first loads of tracked values */
+    std::size_t loads = 0UL;
+    /* loads of values that had been evicted */
+    std::size_t reloads = 0UL;
+    std::size_t evictions = 0UL;
+    std::size_t evicted_bytes = 0UL;
+};
+
+/* Values of one variable, shared by its copies */
+struct slot_t
+{
+    using loader_t = std::function<data_t()>;
+
+    slot_t(loader_t&& loader, CDF_Types type) : loader { std::move(loader) }, type { type } { }
+    slot_t(const slot_t&) = delete;
+    slot_t& operator=(const slot_t&) = delete;
+    ~slot_t();
+
+    loader_t loader;
+    CDF_Types type;
+    std::shared_ptr<data_t> values;
+    /* evicted values, reused as long as somebody else holds them */
+    std::weak_ptr<data_t> evicted_values;
+    std::size_t bytes = 0UL;
+    bool linked = false;
+    bool evicted = false;
+    std::list<slot_t*>::iterator position;
+};
+
+namespace _details
+{
+    struct state_t
+    {
+        std::mutex mutex;
+        std::list<slot_t*> lru;
+        usage_t usage;
+    };
+
+    inline state_t& state()
+    {
+        static state_t s;
+        return s;
+    }
+
+    inline void unlink(state_t& s, slot_t& slot)
+    {
+        if (slot.linked)
+        {
+            s.lru.erase(slot.position);
+            s.usage.resident_bytes -= slot.bytes;
+            s.usage.resident_count--;
+            slot.linked = false;
+        }
+    }
+
+    /* most recently used slots are at the front */
+    inline void touch(state_t& s, slot_t& slot)
+    {
+        if (slot.linked)
+            s.lru.splice(std::begin(s.lru), s.lru, slot.position);
+    }
+
+    inline void link(state_t& s, slot_t& slot, std::shared_ptr<data_t>&& values)
+    {
+        slot.values = std::move(values);
+        slot.bytes = slot.values->bytes();
+        s.lru.push_front(&slot);
+        slot.position = std::begin(s.lru);
+        slot.linked = true;
+        s.usage.resident_bytes += slot.bytes;
+        s.usage.resident_count++;
+        if (slot.evicted)
+            s.usage.reloads++;
+        else
+            s.usage.loads++;
+    }
+
+    /* releases least recently used values until usage fits the budget, keep is never released */
+    inline void evict(state_t& s, const slot_t* keep)
+    {
+        auto it = std::end(s.lru);
+        while (s.usage.budget != 0UL and s.usage.resident_bytes > s.usage.budget
+            and it != std::begin(s.lru))
+        {
+            auto& slot = **(--it);
+            if (&slot == keep)
+                continue;
+            it = s.lru.erase(it);
+            slot.linked = false;
+            slot.evicted = true;
+            slot.evicted_values = slot.values;
+            slot.values.reset();
+            s.usage.resident_bytes -= slot.bytes;
+            s.usage.resident_count--;
+            s.usage.evictions++;
+            s.usage.evicted_bytes += slot.bytes;
+        }
+    }
+}
+
+inline slot_t::~slot_t()
+{
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    _details::unlink(s, *this);
+}
+
+/* Sets the budget in bytes, 0 disables it (default), values above the new budget are evicted */
+inline void set_budget(std::size_t bytes)
+{
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    s.usage.budget = bytes;
+    _details::evict(s, nullptr);
+}
+
+[[nodiscard]] inline std::size_t budget()
+{
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    return s.usage.budget;
+}
+
+[[nodiscard]] inline bool enabled()
+{
+    return budget() != 0UL;
+}
+
+[[nodiscard]] inline usage_t usage()
+{
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    return s.usage;
+}
+
+/* Resets loads and evictions counters */
+inline void reset_counters()
+{
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    s.usage.loads = s.usage.reloads = s.usage.evictions = s.usage.evicted_bytes = 0UL;
+}
+
+[[nodiscard]] inline bool resident(const slot_t& slot)
+{
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    return slot.values != nullptr;
+}
+
+/* Starts tracking values that were just loaded for slot */
+inline void attach(slot_t& slot, data_t&& values)
+{
+    auto shared = std::make_shared<data_t>(std::move(values));
+    auto& s = _details::state();
+    std::lock_guard lock { s.mutex };
+    _details::link(s, slot, std::move(shared));
+    _details::evict(s, &slot);
+}
+
+/*
+ * Returns slot values, loading them again if they were evicted, and marks them as most
+ * recently used. They stay alive as long as the returned pointer is held.
+ */
+[[nodiscard]] inline std::shared_ptr<const data_t> acquire(slot_t& slot)
+{
+    auto& s = _details::state();
+    {
+        std::lock_guard lock { s.mutex };
+        if (slot.values)
+        {
+            _details::touch(s, slot);
+            return slot.values;
+        }
+        if (auto values = slot.evicted_values.lock())
+        {
+            slot.evicted_values.reset();
+            _details::link(s, slot, std::move(values));
+            std::shared_ptr<const data_t> result = slot.values;
+            _details::evict(s, &slot);
+            return result;
+        }
+    }
+    auto values = std::make_shared<data_t>(slot.loader());
+    std::lock_guard lock { s.mutex };
+    if (not slot.values)
+        _details::link(s, slot, std::move(values));
+    else
+        _details::touch(s, slot);
+    std::shared_ptr<const data_t> result = slot.values;
+    _details::evict(s, &slot);
+    return result;
+}
+
+/*
+ * Stops tracking slot and returns its values, they are moved out when nobody else holds
+ * them. Used before values get modified since modified values can't be loaded again.
+ */
+[[nodiscard]] inline data_t take(slot_t& slot)
+{
+    auto values = std::const_pointer_cast<data_t>(acquire(slot));
+    {
+        auto& s = _details::state();
+        std::lock_guard lock { s.mutex };
+        _details::unlink(s, slot);
+        slot.values.reset();
+        slot.evicted_values.reset();
+    }
+    if (values.use_count() == 1)
+        return std::move(*values);
+    return *values;
+}
+
+}
@@ -25,6 +25,7 @@
 ----------------------------------------------------------------------------*/
 #pragma once
 #include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <functional>
 #include <optional>
@@ -95,6 +96,121 @@ struct tuple_element<1, nomap_node<Key, T>>
 
 }
 
+/*
+ * Open addressing (linear probing) index over a nodes vector, slots hold node position + 1
+ * and 0 when empty. Keys are never stored twice, probing compares the nodes keys.
+ */
+template <typename Key>
+struct nomap_index
+{
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    [[nodiscard]] inline bool empty() const noexcept { return std::empty(p_slots); }
+    inline void clear() noexcept { p_slots.clear(); }
+
+    template <typename nodes_t>
+    inline void rebuild(const nodes_t& nodes)
+    {
+        p_slots.assign(std::bit_ceil(std::max<std::size_t>(16UL, 2 * std::size(nodes))), 0U);
+        for (std::size_t i = 0; i < std::size(nodes); i++)
+            p_slots[free_slot(nodes[i].first)] = static_cast<uint32_t>(i + 1);
+    }
+
+    template <typename nodes_t>
+    [[nodiscard]] inline std::size_t find(const nodes_t& nodes, const Key& key) const
+    {
+        for (auto slot = first_slot(key);; slot = next(slot))
+        {
+            const auto position = p_slots[slot];
+            if (position == 0)
+                return npos;
+            if (nodes[position - 1].first == key)
+                return position - 1;
+        }
+    }
+
+    /* indexes the node just appended to nodes */
+    template <typename nodes_t>
+    inline void push_back(const nodes_t& nodes)
+    {
+        if (2 * std::size(nodes) > std::size(p_slots))
+            rebuild(nodes);
+        else
+            p_slots[free_slot(nodes.back().first)] = static_cast<uint32_t>(std::size(nodes));
+    }
+
+    /*
+     * Must be called before nodes[position] is replaced by the last node and the last node
+     * removed, as done by nomap::erase.
+     */
+    template <typename nodes_t>
+    inline void swap_and_pop(const nodes_t& nodes, std::size_t position)
+    {
+        remove(nodes, slot_of(nodes[position].first, position));
+        const auto last = std::size(nodes) - 1;
+        if (position != last)
+            p_slots[slot_of(nodes[last].first, last)] = static_cast<uint32_t>(position + 1);
+    }
+
+    friend void swap(nomap_index& lhs, nomap_index& rhs) noexcept
+    {
+        std::swap(lhs.p_slots, rhs.p_slots);
+    }
+
+private:
+    [[nodiscard]] inline std::size_t next(std::size_t slot) const noexcept
+    {
+        return (slot + 1) & (std::size(p_slots) - 1);
+    }
+
+    [[nodiscard]] inline std::size_t first_slot(const Key& key) const
+    {
+        return std::hash<Key> {}(key) & (std::size(p_slots) - 1);
+    }
+
+    [[nodiscard]] inline std::size_t free_slot(const Key& key) const
+    {
+        auto slot = first_slot(key);
+        while (p_slots[slot] != 0)
+            slot = next(slot);
+        return slot;
+    }
+
+    [[nodiscard]] inline std::size_t slot_of(const Key& key, std::size_t position) const
+    {
+        auto slot = first_slot(key);
+        while (p_slots[slot] != position + 1)
+            slot = next(slot);
+        return slot;
+    }
+
+    /* backward shift deletion, keeps every probe sequence free of holes */
+    template <typename nodes_t>
+    inline void remove(const nodes_t& nodes, std::size_t hole)
+    {
+        const auto mask = std::size(p_slots) - 1;
+        p_slots[hole] = 0;
+        for (auto slot = next(hole); p_slots[slot] != 0; slot = next(slot))
+        {
+            const auto home = first_slot(nodes[p_slots[slot] - 1].first);
+            // moves the entry back into the hole when the hole lies on its probe sequence
+            if (((slot - home) & mask) >= ((slot - hole) & mask))
+            {
+                p_slots[hole] = p_slots[slot];
+                p_slots[slot] = 0;
+                hole = slot;
+            }
+        }
+    }
+
+    std::vector<uint32_t> p_slots;
+};
+
+/*
+ * Map keeping nodes in insertion order (erase moves the last node in place of the erased one).
+ * Small maps are scanned linearly, larger ones are backed by a hash index.
+ * Keys must not be modified through iterators.
+ */
 template <typename Key, typename T>
 struct nomap
 {
@@ -118,11 +234,18 @@ struct nomap
     {
         if (size() != other.size())
             return false;
-        for (const auto& node : p_nodes)
+        for (std::size_t i = 0; i < size(); i++)
         {
-            if (!other.count(node.key()))
-                return false;
-            if (other[node.key()] != node.mapped())
+            const auto& node = p_nodes[i];
+            // maps filled in the same order hold the same key at the same position
+            if (other.p_nodes[i].first == node.first)
+            {
+                if (other.p_nodes[i].second != node.second)
+                    return false;
+                continue;
+            }
+            const auto position = other.find_position(node.first);
+            if (position == npos or other.p_nodes[position].second != node.second)
                 return false;
         }
         return true;
@@ -133,50 +256,42 @@ struct nomap
 
     [[nodiscard]] inline size_type max_size() const noexcept { return p_nodes.max_size(); }
 
-    inline void clear() noexcept { p_nodes.clear(); }
+    inline void clear() noexcept
+    {
+        p_nodes.clear();
+        p_index.clear();
+    }
 
     [[nodiscard]] inline T& at(const key_type& key)
     {
-        for (auto i = 0UL; i < std::size(p_nodes); i++)
-        {
-            if (p_nodes[i].first == key)
-                return p_nodes[i].second;
-        }
-
+        if (const auto position = find_position(key); position != npos)
+            return p_nodes[position].second;
         throw std::out_of_range { "Key not found" };
     }
 
     [[nodiscard]] inline const T& at(const key_type& key) const
     {
-        for (auto i = 0UL; i < std::size(p_nodes); i++)
-        {
-            if (p_nodes[i].first == key)
-                return p_nodes[i].second;
-        }
-
+        if (const auto position = find_position(key); position != npos)
+            return p_nodes[position].second;
         throw std::out_of_range { "Key not found" };
     }
 
     [[nodiscard]] inline T& operator[](const key_type& key)
     {
-        for (auto i = 0UL; i < std::size(p_nodes); i++)
-        {
-            if (p_nodes[i].first == key)
-                return p_nodes[i].second;
-        }
-        auto& node = p_nodes.emplace_back(key, mapped_type {});
-        return node.second;
+        if (const auto position = find_position(key); position != npos)
+            return p_nodes[position].second;
+        p_nodes.emplace_back(key, mapped_type {});
+        index_back();
+        return p_nodes.back().second;
     }
 
     [[nodiscard]] inline T& operator[](key_type&& key)
     {
-        for (auto i = 0UL; i < std::size(p_nodes); i++)
-        {
-            if (p_nodes[i].first == key)
-                return p_nodes[i].second;
-        }
-        auto& node = p_nodes.emplace_back(std::move(key), mapped_type {});
-        return node.second;
+        if (const auto position = find_position(key); position != npos)
+            return p_nodes[position].second;
+        p_nodes.emplace_back(std::move(key), mapped_type {});
+        index_back();
+        return p_nodes.back().second;
     }
 
     [[nodiscard]] inline const T& operator[](const key_type& key) const { return this->at(key); }
@@ -217,8 +332,7 @@ struct nomap
         if (position != end())
         {
             auto next_idx = (position - begin());
-            std::swap(*position, p_nodes.back());
-            p_nodes.pop_back();
+            swap_and_pop(static_cast<std::size_t>(next_idx));
             return begin() + next_idx;
         }
         return end();
@@ -229,8 +343,7 @@ struct nomap
         if (position != cend())
         {
             auto next_idx = (position - cbegin());
-            std::swap(p_nodes[next_idx], p_nodes.back());
-            p_nodes.pop_back();
+            swap_and_pop(static_cast<std::size_t>(next_idx));
             return cbegin() + next_idx;
         }
         return cend();
@@ -248,6 +361,8 @@ struct nomap
                 p_nodes[start_idx + i] = std::move(p_nodes[new_size + i]);
             }
             p_nodes.resize(new_size);
+            if (not p_index.empty())
+                p_index.rebuild(p_nodes);
             return begin() + start_idx;
         }
         return end();
@@ -255,26 +370,27 @@ struct nomap
 
     [[nodiscard]] inline value_type extract(const key_type& key)
     {
-        for (auto i = 0UL; i < std::size(p_nodes); i++)
-        {
-            if (p_nodes[i].first == key)
-                return _extract(i);
-        }
+        if (const auto position = find_position(key); position != npos)
+            return _extract(position);
         return {};
     }
 
-    friend void swap(nomap& lhs, nomap& rhs) { std::swap(lhs.p_nodes, rhs.p_nodes); }
+    friend void swap(nomap& lhs, nomap& rhs)
+    {
+        std::swap(lhs.p_nodes, rhs.p_nodes);
+        swap(lhs.p_index, rhs.p_index);
+    }
 
     [[nodiscard]] auto find(const key_type& key)
     {
-        return std::find_if(std::begin(p_nodes), std::end(p_nodes),
-            [&key](const auto& node) { return node.first == key; });
+        const auto position = find_position(key);
+        return position == npos ? end() : begin() + static_cast<difference_type>(position);
     }
 
     [[nodiscard]] auto find(const key_type& key) const
     {
-        return std::find_if(std::cbegin(p_nodes), std::cend(p_nodes),
-            [&key](const auto& node) { return node.first == key; });
+        const auto position = find_position(key);
+        return position == npos ? cend() : cbegin() + static_cast<difference_type>(position);
     }
 
     [[nodiscard]] size_type count(const Key& key) const
@@ -294,6 +410,7 @@ struct nomap
         {
             p_nodes.emplace_back(
                 std::forward<Kt>(key), mapped_type { std::forward<Args>(args)... });
+            index_back();
             return { p_nodes.end() - 1, true };
         }
         return { it, false };
@@ -301,12 +418,50 @@ struct nomap
 
 
 private:
+    static constexpr std::size_t npos = nomap_index<key_type>::npos;
+    /* below this size a linear scan is faster than hashing the key */
+    static constexpr std::size_t index_threshold = 16UL;
+
+    [[nodiscard]] inline std::size_t find_position(const key_type& key) const
+    {
+        if (not p_index.empty())
+            return p_index.find(p_nodes, key);
+        for (auto i = 0UL; i < std::size(p_nodes); i++)
+        {
+            if (p_nodes[i].first == key)
+                return i;
+        }
+        return npos;
+    }
+
+    inline void index_back()
+    {
+        if (not p_index.empty())
+            p_index.push_back(p_nodes);
+        else if (std::size(p_nodes) > index_threshold)
+            p_index.rebuild(p_nodes);
+    }
+
+    /* replaces the node at position by the last one, like erase always did */
+    inline void swap_and_pop(std::size_t position)
+    {
+        if (not p_index.empty())
+            p_index.swap_and_pop(p_nodes, position);
+        std::swap(p_nodes[position], p_nodes.back());
+        p_nodes.pop_back();
+    }
+
     inline value_type _extract(std::size_t index)
     {
+        if (not p_index.empty())
+            p_index.swap_and_pop(p_nodes, index);
         std::swap(p_nodes[size() - 1], p_nodes[index]);
         value_type v = std::move(p_nodes[size() - 1]);
         p_nodes.pop_back();
         return v;
     }
+
     std::vector<value_type> p_nodes;
+    /* only built once the map holds more than index_threshold nodes */
+    nomap_index<key_type> p_index;
 };
@@ -31,12 +31,17 @@
 #include "cdf-io/majority-swap.hpp"
 #include "cdf-map.hpp"
 #include "cdf-repr.hpp"
+#include "memory-budget.hpp"
 #include "no_init_vector.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <iomanip>
+#include <memory>
 #include <optional>
 #include <source_location>
+#include <span>
 #include <vector>
 
 #include <fmt/core.h>
@@ -134,7 +139,7 @@ struct Variable
     {
         return other.p_name == p_name && other.p_is_nrv == p_is_nrv
             && other.p_compression == p_compression && other.p_shape == p_shape
-            && other.attributes == attributes && other._data() == _data();
+            && other.attributes == attributes && *other._shared_data() == *_shared_data();
     }
 
     template <CDF_Types type>
@@ -173,11 +178,13 @@ struct Variable
 
     void set_data(const Variable& source)
     {
-        p_data = source._data();
+        p_data = *source._shared_data();
+        p_pinned.reset();
         p_shape = source.p_shape;
         p_is_nrv = source.p_is_nrv;
         p_majority = source.p_majority;
         p_compression = source.p_compression;
+        p_column_major_values = source.p_column_major_values;
         check_shape();
     }
 
@@ -185,7 +192,9 @@ struct Variable
     void set_data(const data_t& data, const shape_t& shape)
     {
         p_data = data;
+        p_pinned.reset();
         p_shape = shape;
+        p_column_major_values = false;
         check_shape();
     }
 
@@ -193,14 +202,18 @@ struct Variable
     void set_data(data_t&& data, shape_t&& shape)
     {
         p_data = std::move(data);
+        p_pinned.reset();
         p_shape = std::move(shape);
+        p_column_major_values = false;
         check_shape();
     }
 
     void set_data(std::pair<data_t, shape_t>&& data)
     {
         p_data = std::move(data.first);
+        p_pinned.reset();
         p_shape = std::move(data.second);
+        p_column_major_values = false;
         check_shape();
     }
 
@@ -212,13 +225,15 @@ struct Variable
             return 0UL;
     }
 
-    [[nodiscard]] const char* bytes_ptr() const noexcept { return _data().bytes_ptr(); }
-    [[nodiscard]] char* bytes_ptr() noexcept { return _data().bytes_ptr(); }
+    [[nodiscard]] const char* bytes_ptr() const { return _data().bytes_ptr(); }
+    [[nodiscard]] char* bytes_ptr() { return _data().bytes_ptr(); }
 
     [[nodiscard]] CDF_Types type() const
     {
         if (std::holds_alternative<var_data_t>(p_data))
             return std::get<var_data_t>(p_data).type();
+        if (std::holds_alternative<budgeted_data_t>(p_data))
+            return std::get<budgeted_data_t>(p_data)->type;
         return std::get<lazy_data>(p_data).type();
     }
 
@@ -230,23 +245,202 @@ struct Variable
 
     [[nodiscard]] inline bool values_loaded() const noexcept
     {
-        return not std::holds_alternative<lazy_data>(p_data);
+        if (std::holds_alternative<budgeted_data_t>(p_data))
+            return memory_budget::resident(*std::get<budgeted_data_t>(p_data));
+        return std::holds_alternative<var_data_t>(p_data);
+    }
+
+    /* true when values are read directly from the mapped file, see data_t::is_mapped */
+    [[nodiscard]] inline bool values_mapped() const noexcept
+    {
+        return std::holds_alternative<var_data_t>(p_data)
+            and std::get<var_data_t>(p_data).is_mapped();
+    }
+
+    /*
+     * true when values count in the memory budget (see memory_budget), they can be released
+     * and loaded again at any budgeted load. Values reached through const get() or bytes_ptr()
+     * are pinned by the variable until it is modified or destroyed, use budgeted_values() to
+     * only keep them alive for a given scope.
+     * Mutable access takes them out of the budget since modified values can't be loaded again.
+     */
+    [[nodiscard]] inline bool values_budgeted() const noexcept
+    {
+        return std::holds_alternative<budgeted_data_t>(p_data);
+    }
+
+    /*
+     * Keeps values of a column major variable in file order instead of transposing each record
+     * to row major, which is wasted work when only a few elements per record are used. Values
+     * are then stored with Fortran order inside records (see strides), records stay contiguous.
+     * Only possible for lazy non string variables with more than one dimension per record whose
+     * values are not loaded yet, returns true when values are kept in file order.
+     */
+    bool keep_column_major()
+    {
+        if (not p_column_major_values and p_majority == cdf_majority::column
+            and std::size(p_shape) > 2 and std::holds_alternative<lazy_data>(p_data)
+            and std::get<lazy_data>(p_data).can_load_records()
+            and type() != CDF_Types::CDF_CHAR and type() != CDF_Types::CDF_UCHAR)
+            p_column_major_values = true;
+        return p_column_major_values;
+    }
+
+    /* true when values are kept in file column major order, see keep_column_major */
+    [[nodiscard]] bool values_column_major() const noexcept { return p_column_major_values; }
+
+    /* values strides in bytes, in shape order */
+    [[nodiscard]] std::vector<std::size_t> strides() const
+    {
+        const auto rank = std::size(p_shape);
+        std::vector<std::size_t> result(rank);
+        std::size_t stride = cdf_type_size(type());
+        if (p_column_major_values)
+        {
+            for (auto dim = 1UL; dim < rank; dim++)
+            {
+                result[dim] = stride;
+                stride *= p_shape[dim];
+            }
+            if (rank)
+                result[0] = stride;
+        }
+        else
+        {
+            for (auto dim = rank; dim-- > 0;)
+            {
+                result[dim] = stride;
+                stride *= p_shape[dim];
+            }
+        }
+        return result;
+    }
+
+    /* transposes values kept in file order to row major, see keep_column_major */
+    void to_row_major()
+    {
+        if (p_column_major_values)
+        {
+            if (not std::holds_alternative<lazy_data>(p_data))
+                majority::swap(_data(), p_shape);
+            p_column_major_values = false;
+        }
+    }
+
+    /* budgeted values kept alive as long as the returned pointer is held, see values_budgeted */
+    [[nodiscard]] std::shared_ptr<const data_t> budgeted_values() const
+    {
+        if (values_budgeted())
+            return memory_budget::acquire(*std::get<budgeted_data_t>(p_data));
+        return nullptr;
     }
 
     inline void load_values() const
     {
-        if (not values_loaded())
+        if (std::holds_alternative<lazy_data>(p_data))
         {
-            p_data = std::get<lazy_data>(p_data).load();
-            auto& data = std::get<data_t>(p_data);
-            if (this->majority() == cdf_majority::column)
+            const auto& lazy_values = std::get<lazy_data>(p_data);
+            auto loader = [lazy = lazy_values, shape = p_shape,
+                              column_major = p_majority == cdf_majority::column
+                                  and not lazy_values.values_row_major(),
+                              file_order = p_column_major_values]() mutable
+            {
+                // records loaders return values in file order
+                if (file_order)
+                    return lazy.load_records(0UL, shape[0]);
+                auto data = lazy.load();
+                if (column_major)
+                {
+                    majority::swap(data, shape);
+                }
+                return data;
+            };
+            auto data = loader();
+            if (memory_budget::enabled() and not data.is_mapped())
             {
-                majority::swap(data, p_shape);
+                auto slot = std::make_shared<memory_budget::slot_t>(std::move(loader), data.type());
+                memory_budget::attach(*slot, std::move(data));
+                p_data = std::move(slot);
+            }
+            else
+            {
+                p_data = std::move(data);
             }
             check_shape();
         }
     }
 
+    /*
+     * Returns a new variable holding only records [first, last), last is clamped to len().
+     * When values are not loaded yet, only the file blocks overlapping the requested range
+     * are read (and decompressed), values of this variable stay unloaded.
+     */
+    [[nodiscard]] Variable load_records(std::size_t first, std::size_t last) const
+    {
+        last = std::min(last, len());
+        first = std::min(first, last);
+        shape_t shape = p_shape;
+        if (std::size(shape))
+            shape[0] = static_cast<uint32_t>(last - first);
+        Variable result { p_name, p_number, var_data_t {}, shape_t {}, p_majority, p_is_nrv,
+            p_compression };
+        result.attributes = attributes;
+        if (std::holds_alternative<lazy_data>(p_data)
+            and std::get<lazy_data>(p_data).can_load_records())
+        {
+            auto data = std::get<lazy_data>(p_data).load_records(first, last);
+            if (this->majority() == cdf_majority::column and not p_column_major_values)
+            {
+                majority::swap(data, shape);
+            }
+            result.set_data(std::move(data), std::move(shape));
+        }
+        else
+        {
+            const auto values = _shared_data();
+            const auto& data = *values;
+            const std::size_t record_bytes
+                = std::size(p_shape) ? bytes() / std::max(std::size_t { 1 }, len()) : 0UL;
+            auto slice = new_data_container((last - first) * record_bytes, data.type());
+            if (slice.bytes())
+                std::memcpy(slice.bytes_ptr(), data.bytes_ptr() + first * record_bytes,
+                    slice.bytes());
+            result.set_data(std::move(slice), std::move(shape));
+        }
+        result.p_column_major_values = p_column_major_values;
+        return result;
+    }
+
+    /*
+     * Copies the values of records [first, last) into dest, which must hold at least
+     * (last - first) records. When values are not loaded yet and the file layout allows it,
+     * records are decoded straight into dest without intermediate copy.
+     */
+    void copy_records_to(char* dest, std::size_t first, std::size_t last) const
+    {
+        last = std::min(last, len());
+        first = std::min(first, last);
+        if (last == first)
+            return;
+        // with at most one dimension per record, majority doesn't change records layout
+        if (std::holds_alternative<lazy_data>(p_data)
+            and (std::size(p_shape) <= 2 or majority() == cdf_majority::row
+                or p_column_major_values)
+            and std::get<lazy_data>(p_data).load_records_into(dest, first, last))
+        {
+            if (p_column_major_values)
+                swap_records(dest, last - first);
+            return;
+        }
+        const auto values = _shared_data();
+        const auto& data = *values;
+        const std::size_t record_bytes = bytes() / len();
+        const std::size_t offset = std::min(first * record_bytes, data.bytes());
+        std::memcpy(dest, data.bytes_ptr() + offset,
+            std::min((last - first) * record_bytes, data.bytes() - offset));
+        if (p_column_major_values)
+            swap_records(dest, last - first);
+    }
 
     template <typename... Ts>
     friend auto visit(Variable& var, Ts... lambdas);
@@ -279,25 +473,66 @@ struct Variable
 
 
 private:
+    using budgeted_data_t = std::shared_ptr<memory_budget::slot_t>;
+
     [[nodiscard]] var_data_t& _data()
     {
         load_values();
+        if (std::holds_alternative<budgeted_data_t>(p_data))
+        {
+            p_pinned.reset();
+            p_data = memory_budget::take(*std::get<budgeted_data_t>(p_data));
+        }
         return std::get<var_data_t>(p_data);
     }
 
+    /* references to budgeted values stay valid as long as this variable pins them */
     [[nodiscard]] const var_data_t& _data() const
     {
         load_values();
+        if (std::holds_alternative<budgeted_data_t>(p_data))
+        {
+            p_pinned = memory_budget::acquire(*std::get<budgeted_data_t>(p_data));
+            return *p_pinned;
+        }
         return std::get<var_data_t>(p_data);
     }
 
-    void check_shape() const
+    /* values kept alive as long as the returned pointer is held, without pinning them */
+    [[nodiscard]] std::shared_ptr<const var_data_t> _shared_data() const
     {
+        load_values();
+        if (std::holds_alternative<budgeted_data_t>(p_data))
+            return memory_budget::acquire(*std::get<budgeted_data_t>(p_data));
+        // non owning, values live as long as this variable
+        return { std::shared_ptr<const var_data_t> {}, &std::get<var_data_t>(p_data) };
+    }
 
-        if (flat_size(p_shape) != _data().size()
-            and not(is_nrv() and _data().size() == 0UL
-                and (_data().type() == CDF_Types::CDF_CHAR
-                    or _data().type() == CDF_Types::CDF_UCHAR)))
+    /* transposes records copied in file order to row major */
+    void swap_records(char* values, std::size_t records) const
+    {
+        shape_t shape = p_shape;
+        shape[0] = static_cast<uint32_t>(records);
+        cdf_type_dispatch(type(),
+            [&]<CDF_Types t>()
+            {
+                if constexpr (not is_cdf_string_type(t))
+                {
+                    std::span<from_cdf_type_t<t>> records_values {
+                        reinterpret_cast<from_cdf_type_t<t>*>(values), flat_size(shape)
+                    };
+                    majority::swap<false>(records_values, shape);
+                }
+            });
+    }
+
+    void check_shape() const
+    {
+        const auto values = _shared_data();
+        const auto& data = *values;
+        if (flat_size(p_shape) != data.size()
+            and not(is_nrv() and data.size() == 0UL
+                and (data.type() == CDF_Types::CDF_CHAR or data.type() == CDF_Types::CDF_UCHAR)))
             throw std::invalid_argument { exception_message(fmt::format(R"(
 Variable: given shape and data size doesn't match:
 Variable name: "{}"
@@ -305,16 +540,19 @@ Variable name: "{}"
 Data:
     size: {}
 )",
-                p_name, p_shape, flat_size(p_shape), _data().size())) };
+                p_name, p_shape, flat_size(p_shape), data.size())) };
     }
 
     std::string p_name;
     std::size_t p_number;
-    mutable std::variant<lazy_data, var_data_t> p_data;
+    mutable std::variant<lazy_data, var_data_t, budgeted_data_t> p_data;
+    /* budgeted values referenced by const accessors, see values_budgeted */
+    mutable std::shared_ptr<const var_data_t> p_pinned;
     shape_t p_shape;
     cdf_majority p_majority;
     bool p_is_nrv;
     cdf_compression_type p_compression;
+    bool p_column_major_values = false;
 };
 
 template <typename... Ts>
@@ -0,0 +1,145 @@
+/*------------------------------------------------------------------------------
+-- The MIT License (MIT)
+--
+-- Copyright © 2025, Laboratory of Plasma Physics- CNRS
+--
+-- Permission is hereby granted, free of charge, to any person obtaining a copy
+-- of this software and associated documentation files (the “Software”), to deal
+-- in the Software without restriction, including without limitation the rights
+-- to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+-- of the Software, and to permit persons to whom the Software is furnished to do
+-- so, subject to the following conditions:
+--
+-- The above copyright notice and this permission notice shall be included in all
+-- copies or substantial portions of the Software.
+--
+-- THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+-- INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+-- PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+-- HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+-- OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+-- SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+-------------------------------------------------------------------------------*/
+/*-- Author : Alexis Jeandet
+-- Mail : alexis.jeandet@member.fsf.org
+----------------------------------------------------------------------------*/
+#pragma once
+#include "cdfpp/cdf-io/endianness.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <xsimd/xsimd.hpp>
+
+namespace cdf::endianness::vectorized
+{
+
+/* SSE2 has no byte shuffle, bytes are swapped with shifts and masks */
+template <typename T, class Arch>
+static inline xsimd::batch<T, Arch> shift_byte_swap(xsimd::batch<T, Arch> x)
+{
+    if constexpr (sizeof(T) == 2)
+    {
+        return (x << 8) | (x >> 8);
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        const auto m8 = xsimd::batch<T, Arch>::broadcast(0x00FF00FFU);
+        x = ((x & m8) << 8) | ((x >> 8) & m8);
+        return (x << 16) | (x >> 16);
+    }
+    else
+    {
+        const auto m8 = xsimd::batch<T, Arch>::broadcast(0x00FF00FF00FF00FFULL);
+        const auto m16 = xsimd::batch<T, Arch>::broadcast(0x0000FFFF0000FFFFULL);
+        x = ((x & m8) << 8) | ((x >> 8) & m8);
+        x = ((x & m16) << 16) | ((x >> 16) & m16);
+        return (x << 32) | (x >> 32);
+    }
+}
+
+/* pshufb mask reversing bytes inside each sizeof(T) group, it never crosses 128 bits lanes */
+template <typename T>
+inline constexpr auto byte_swap_mask = []()
+{
+    std::array<int8_t, 64> mask {};
+    for (std::size_t i = 0; i < std::size(mask); i++)
+        mask[i] = static_cast<int8_t>(
+            (i % 16) / sizeof(T) * sizeof(T) + (sizeof(T) - 1 - i % sizeof(T)));
+    return mask;
+}();
+
+template <class Arch, typename T>
+static inline void shuffle_byte_swap(T* const data)
+{
+    if constexpr (std::is_base_of_v<xsimd::avx512bw, Arch>)
+    {
+#if defined(__AVX512BW__)
+        const auto mask = _mm512_loadu_si512(std::data(byte_swap_mask<T>));
+        auto* const p = reinterpret_cast<__m512i*>(data);
+        _mm512_storeu_si512(p, _mm512_shuffle_epi8(_mm512_loadu_si512(p), mask));
+#endif
+    }
+    else if constexpr (std::is_base_of_v<xsimd::avx2, Arch>)
+    {
+#if defined(__AVX2__)
+        const auto mask
+            = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(std::data(byte_swap_mask<T>)));
+        auto* const p = reinterpret_cast<__m256i*>(data);
+        _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), mask));
+#endif
+    }
+}
+
+struct _byte_swap_t
+{
+    template <class Arch, typename T>
+    void operator()(Arch, T* const data, std::size_t size);
+};
+
+template <class Arch, typename T>
+void _byte_swap_t::operator()(Arch, T* const data, std::size_t size)
+{
+    using batch_t = xsimd::batch<T, Arch>;
+    constexpr std::size_t simd_size = batch_t::size;
+    std::size_t i = 0;
+    if constexpr (std::is_base_of_v<xsimd::avx2, Arch>)
+    {
+        for (; i + simd_size <= size; i += simd_size)
+            shuffle_byte_swap<Arch>(data + i);
+    }
+    else
+    {
+        for (; i + simd_size <= size; i += simd_size)
+            shift_byte_swap(batch_t::load_unaligned(data + i)).store_unaligned(data + i);
+    }
+    for (; i < size; i++)
+        data[i] = byte_swap(data[i]);
+}
+
+#ifdef CDFPP_ENABLE_SSE2_ARCH
+extern template void _byte_swap_t::operator()<xsimd::sse2>(
+    xsimd::sse2, uint16_t* const data, std::size_t size);
+extern template void _byte_swap_t::operator()<xsimd::sse2>(
+    xsimd::sse2, uint32_t* const data, std::size_t size);
+extern template void _byte_swap_t::operator()<xsimd::sse2>(
+    xsimd::sse2, uint64_t* const data, std::size_t size);
+#endif
+#ifdef CDFPP_ENABLE_AVX2_ARCH
+extern template void _byte_swap_t::operator()<xsimd::avx2>(
+    xsimd::avx2, uint16_t* const data, std::size_t size);
+extern template void _byte_swap_t::operator()<xsimd::avx2>(
+    xsimd::avx2, uint32_t* const data, std::size_t size);
+extern template void _byte_swap_t::operator()<xsimd::avx2>(
+    xsimd::avx2, uint64_t* const data, std::size_t size);
+#endif
+#ifdef CDFPP_ENABLE_AVX512BW_ARCH
+extern template void _byte_swap_t::operator()<xsimd::avx512bw>(
+    xsimd::avx512bw, uint16_t* const data, std::size_t size);
+extern template void _byte_swap_t::operator()<xsimd::avx512bw>(
+    xsimd::avx512bw, uint32_t* const data, std::size_t size);
+extern template void _byte_swap_t::operator()<xsimd::avx512bw>(
+    xsimd::avx512bw, uint64_t* const data, std::size_t size);
+#endif
+
+} // namespace cdf::endianness::vectorized
@@ -0,0 +1,271 @@
+/*------------------------------------------------------------------------------
+-- The MIT License (MIT)
+--
+-- Copyright © 2025, Laboratory of Plasma Physics- CNRS
+--
+-- Permission is hereby granted, free of charge, to any person obtaining a copy
+-- of this software and associated documentation files (the “Software”), to deal
+-- in the Software without restriction, including without limitation the rights
+-- to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+-- of the Software, and to permit persons to whom the Software is furnished to do
+-- so, subject to the following conditions:
+--
+-- The above copyright notice and this permission notice shall be included in all
+-- copies or substantial portions of the Software.
+--
+-- THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+-- INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+-- PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+-- HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+-- OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+-- SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+-------------------------------------------------------------------------------*/
+/*-- Author : Alexis Jeandet
+-- Mail : alexis.jeandet@member.fsf.org
+----------------------------------------------------------------------------*/
+#pragma once
+#include "cdfpp/cdf-data.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <xsimd/xsimd.hpp>
+
+namespace cdf::utf8::vectorized
+{
+
+#if defined(__AVX2__)
+/*
+ * Lookup based UTF-8 validation from "Validating UTF-8 In Less Than One Instruction Per Byte"
+ * (J. Keiser, D. Lemire), each byte pair is classified from three 16 entries tables indexed by
+ * the previous byte nibbles and the current byte high nibble, an error remains when the three
+ * classifications share a bit. Longer sequences are checked from the two and three bytes back.
+ */
+namespace avx2
+{
+    inline constexpr uint8_t too_short = 1 << 0;
+    inline constexpr uint8_t too_long = 1 << 1;
+    inline constexpr uint8_t overlong_3 = 1 << 2;
+    inline constexpr uint8_t too_large = 1 << 3;
+    inline constexpr uint8_t surrogate = 1 << 4;
+    inline constexpr uint8_t overlong_2 = 1 << 5;
+    inline constexpr uint8_t too_large_1000 = 1 << 6;
+    inline constexpr uint8_t overlong_4 = 1 << 6;
+    inline constexpr uint8_t two_conts = 1 << 7;
+    inline constexpr uint8_t carry = too_short | too_long | two_conts;
+
+    template <typename... T>
+    inline __m256i table(T... values)
+    {
+        static_assert(sizeof...(T) == 16);
+        return _mm256_setr_epi8(static_cast<char>(values)..., static_cast<char>(values)...);
+    }
+
+    inline __m256i high_nibbles(__m256i v)
+    {
+        return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+    }
+
+    /* input shifted by N bytes with the last bytes of the previous block in front */
+    template <int N>
+    inline __m256i prev(__m256i input, __m256i prev_input)
+    {
+        return _mm256_alignr_epi8(
+            input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+    }
+
+    inline __m256i special_cases(__m256i input, __m256i prev1)
+    {
+        const auto byte_1_high = _mm256_shuffle_epi8(
+            table(too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                two_conts, two_conts, two_conts, two_conts, too_short | overlong_2, too_short,
+                too_short | overlong_3 | surrogate,
+                too_short | too_large | too_large_1000 | overlong_4),
+            high_nibbles(prev1));
+        const auto byte_1_low = _mm256_shuffle_epi8(
+            table(carry | overlong_3 | overlong_2 | overlong_4, carry | overlong_2, carry, carry,
+                carry | too_large, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000 | surrogate,
+                carry | too_large | too_large_1000, carry | too_large | too_large_1000),
+            _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)));
+        const auto byte_2_high = _mm256_shuffle_epi8(
+            table(too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                too_short,
+                too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+                too_long | overlong_2 | two_conts | overlong_3 | too_large,
+                too_long | overlong_2 | two_conts | surrogate | too_large,
+                too_long | overlong_2 | two_conts | surrogate | too_large, too_short, too_short,
+                too_short, too_short),
+            high_nibbles(input));
+        return _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+    }
+
+    struct checker_t
+    {
+        __m256i error = _mm256_setzero_si256();
+        __m256i prev_input = _mm256_setzero_si256();
+        __m256i prev_incomplete = _mm256_setzero_si256();
+
+        inline void check(__m256i input)
+        {
+            if (_mm256_movemask_epi8(input) == 0)
+            {
+                // an ASCII block can't complete a sequence started in the previous one
+                error = _mm256_or_si256(error, prev_incomplete);
+                prev_incomplete = _mm256_setzero_si256();
+            }
+            else
+            {
+                const auto prev1 = prev<1>(input, prev_input);
+                const auto prev2 = prev<2>(input, prev_input);
+                const auto prev3 = prev<3>(input, prev_input);
+                // third bytes of 3 and 4 bytes sequences and fourth bytes of 4 bytes ones
+                const auto must_be_continuation = _mm256_and_si256(
+                    _mm256_or_si256(
+                        _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80))),
+                        _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)))),
+                    _mm256_set1_epi8(static_cast<char>(0x80)));
+                error = _mm256_or_si256(error,
+                    _mm256_xor_si256(must_be_continuation, special_cases(input, prev1)));
+                // sequences started in the last three bytes
+                prev_incomplete = _mm256_subs_epu8(input,
+                    _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                        static_cast<char>(0xf0 - 1), static_cast<char>(0xe0 - 1),
+                        static_cast<char>(0xc0 - 1)));
+            }
+            prev_input = input;
+        }
+
+        [[nodiscard]] inline bool valid() const
+        {
+            const auto e = _mm256_or_si256(error, prev_incomplete);
+            return _mm256_testz_si256(e, e) != 0;
+        }
+    };
+}
+#endif
+
+struct _is_valid_utf8_t
+{
+    template <class Arch>
+    bool operator()(Arch, const char* const data, std::size_t size);
+};
+
+template <class Arch>
+bool _is_valid_utf8_t::operator()(Arch, const char* const data, std::size_t size)
+{
+    if constexpr (std::is_base_of_v<xsimd::avx2, Arch>)
+    {
+#if defined(__AVX2__)
+        avx2::checker_t checker;
+        std::size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+            checker.check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+        if (i < size)
+        {
+            // zero padding is ASCII, a truncated sequence is still reported as too short
+            char tail[32] = { 0 };
+            std::memcpy(tail, data + i, size - i);
+            checker.check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail)));
+        }
+        return checker.valid();
+#endif
+    }
+    // SSE2 has no byte shuffle, leading ASCII blocks are skipped before the scalar DFA
+    using batch_t = xsimd::batch<int8_t, Arch>;
+    constexpr std::size_t simd_size = batch_t::size;
+    const auto zero = batch_t::broadcast(0);
+    const auto* const bytes = reinterpret_cast<const int8_t*>(data);
+    std::size_t i = 0;
+    for (; i + simd_size <= size; i += simd_size)
+    {
+        if (xsimd::any(batch_t::load_unaligned(bytes + i) < zero))
+            break;
+    }
+    return cdf::_details::scalar_is_valid_utf8(data + i, size - i);
+}
+
+struct _latin1_utf8_size_t
+{
+    template <class Arch>
+    std::size_t operator()(Arch, const char* const data, std::size_t size);
+};
+
+template <class Arch>
+std::size_t _latin1_utf8_size_t::operator()(Arch, const char* const data, std::size_t size)
+{
+    using batch_t = xsimd::batch<int8_t, Arch>;
+    constexpr std::size_t simd_size = batch_t::size;
+    const auto zero = batch_t::broadcast(0);
+    const auto* const bytes = reinterpret_cast<const int8_t*>(data);
+    std::size_t result = 0;
+    std::size_t i = 0;
+    for (; i + simd_size <= size; i += simd_size)
+    {
+        result += simd_size
+            + static_cast<std::size_t>(
+                std::popcount((batch_t::load_unaligned(bytes + i) < zero).mask()));
+    }
+    return result + cdf::_details::scalar_latin1_utf8_size(data + i, size - i);
+}
+
+struct _latin1_to_utf8_t
+{
+    template <class Arch>
+    void operator()(Arch, const char* const data, std::size_t size, char* out);
+};
+
+/* ASCII blocks are stored as is, blocks with latin1 characters are expanded byte per byte */
+template <class Arch>
+void _latin1_to_utf8_t::operator()(Arch, const char* const data, std::size_t size, char* out)
+{
+    using batch_t = xsimd::batch<int8_t, Arch>;
+    constexpr std::size_t simd_size = batch_t::size;
+    const auto zero = batch_t::broadcast(0);
+    const auto* const bytes = reinterpret_cast<const int8_t*>(data);
+    std::size_t i = 0;
+    for (; i + simd_size <= size; i += simd_size)
+    {
+        const auto block = batch_t::load_unaligned(bytes + i);
+        const auto high_bytes = static_cast<std::size_t>(std::popcount((block < zero).mask()));
+        if (high_bytes == 0)
+            block.store_unaligned(reinterpret_cast<int8_t*>(out));
+        else
+            cdf::_details::scalar_latin1_to_utf8(data + i, simd_size, out);
+        out += simd_size + high_bytes;
+    }
+    cdf::_details::scalar_latin1_to_utf8(data + i, size - i, out);
+}
+
+#ifdef CDFPP_ENABLE_SSE2_ARCH
+extern template bool _is_valid_utf8_t::operator()<xsimd::sse2>(
+    xsimd::sse2, const char* const data, std::size_t size);
+extern template std::size_t _latin1_utf8_size_t::operator()<xsimd::sse2>(
+    xsimd::sse2, const char* const data, std::size_t size);
+extern template void _latin1_to_utf8_t::operator()<xsimd::sse2>(
+    xsimd::sse2, const char* const data, std::size_t size, char* out);
+#endif
+#ifdef CDFPP_ENABLE_AVX2_ARCH
+extern template bool _is_valid_utf8_t::operator()<xsimd::avx2>(
+    xsimd::avx2, const char* const data, std::size_t size);
+extern template std::size_t _latin1_utf8_size_t::operator()<xsimd::avx2>(
+    xsimd::avx2, const char* const data, std::size_t size);
+extern template void _latin1_to_utf8_t::operator()<xsimd::avx2>(
+    xsimd::avx2, const char* const data, std::size_t size, char* out);
+#endif
+#ifdef CDFPP_ENABLE_AVX512BW_ARCH
+extern template bool _is_valid_utf8_t::operator()<xsimd::avx512bw>(
+    xsimd::avx512bw, const char* const data, std::size_t size);
+extern template std::size_t _latin1_utf8_size_t::operator()<xsimd::avx512bw>(
+    xsimd::avx512bw, const char* const data, std::size_t size);
+extern template void _latin1_to_utf8_t::operator()<xsimd::avx512bw>(
+    xsimd::avx512bw, const char* const data, std::size_t size, char* out);
+#endif
+
+} // namespace cdf::utf8::vectorized
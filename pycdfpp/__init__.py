@@ -24,7 +24,9 @@ import re
 import numpy as np
 
 from ._pycdfpp import DataType, CompressionType, Majority, Variable, VariableAttribute, Attribute, CDF, tt2000_t, epoch, \
-    epoch16, save
+    epoch16, save, append, set_max_threads, max_threads, IOPolicy, load_metadata, load_many, \
+    set_header_cache_directory, header_cache_directory, set_memory_budget, memory_budget, memory_usage, \
+    reset_memory_counters
 from . import _pycdfpp
 
 # ByteString is deprecated in Python 3.9+ and removed in Python 3.14
@@ -36,8 +38,11 @@ sys.path.append(__here__)
 if sys.platform == 'win32' and sys.version_info[0] == 3 and sys.version_info[1] >= 8:
     os.add_dll_directory(__here__)
 
-__all__ = ['tt2000_t', 'epoch', 'epoch16', 'load', 'save', 'CDF', 'Variable',
-           'Attribute', 'to_datetime64', 'to_datetime', 'to_time_string', 'DataType', 'CompressionType', 'Majority']
+__all__ = ['tt2000_t', 'epoch', 'epoch16', 'load', 'save', 'append', 'CDF', 'Variable',
+           'Attribute', 'to_datetime64', 'to_datetime', 'to_time_string', 'DataType', 'CompressionType', 'Majority',
+           'set_max_threads', 'max_threads', 'IOPolicy', 'load_metadata',
+           'load_many', 'set_header_cache_directory', 'header_cache_directory', 'set_memory_budget',
+           'memory_budget', 'memory_usage', 'reset_memory_counters']
 
 _NUMPY_TO_CDF_TYPE_ = (
     DataType.CDF_NONE,
@@ -767,7 +772,23 @@ to convert to CDF epoch16
     return _pycdfpp.to_epoch16(values)
 
 
-def load(file_or_buffer: str or ByteString, iso_8859_1_to_utf8: bool = True, lazy_load: bool = True):
+def _make_variable_selector(variables):
+    if isinstance(variables, (list, tuple, set, frozenset)):
+        return list(variables)
+    elif isinstance(variables, str):
+        return re.compile(variables).match
+    elif isinstance(variables, re.Pattern):
+        return variables.match
+    elif callable(variables):
+        return lambda name: bool(variables(name))
+    else:
+        raise TypeError(f"Unsupported type for variables selection: {type(variables)}")
+
+
+def load(file_or_buffer: str or ByteString, iso_8859_1_to_utf8: bool = True, lazy_load: bool = True,
+         io_policy: IOPolicy = IOPolicy.automatic,
+         variables: Union[List[str], str, re.Pattern, Callable[[str], bool]] = None,
+         keep_column_major: bool = False):
     """
     Load and parse a CDF file.
 
@@ -784,6 +805,22 @@ def load(file_or_buffer: str or ByteString, iso_8859_1_to_utf8: bool = True, laz
         Controls whether variable values are loaded immediately or only when accessed by the user.
         If True, variables' values are loaded on demand. If False, all variable values are loaded during parsing.
         (Default is True)
+    io_policy : IOPolicy, optional
+        How a file is read, ignored for in-memory files. IOPolicy.automatic maps the file for lazy loads and reads
+        small files at once for eager loads. Other policies are mmap, mmap_sequential, mmap_willneed, mmap_populate,
+        mmap_drop_behind (evicts values pages from the page cache once decoded), pread, read_all and direct (O_DIRECT
+        when supported).
+        (Default is IOPolicy.automatic)
+    variables : Union[List[str], str, re.Pattern, Callable[[str], bool]], optional
+        Only loads the selected variables, either a list of names, a regex pattern or a callable taking a variable
+        name. Other variables and their attributes entries are skipped while parsing, which is much cheaper than
+        loading everything and filtering afterward. Only supported when loading from a file.
+        (Default is None, all variables are loaded)
+    keep_column_major : bool, optional
+        Keeps values of column major variables in file order instead of transposing each record to row major, their
+        `values` are then exposed with Fortran order strides inside records, which avoids transposing records when only
+        a few elements per record are used. Only applies to lazily loaded variables (see `Variable.keep_column_major`).
+        (Default is False)
 
     Returns
     -------
@@ -791,8 +828,21 @@ def load(file_or_buffer: str or ByteString, iso_8859_1_to_utf8: bool = True, laz
         Returns a CDF object upon successful read.
         If there's an issue with the read, None is returned.
     """
+    cdf = _load(file_or_buffer, iso_8859_1_to_utf8, lazy_load, io_policy, variables)
+    if keep_column_major and cdf is not None:
+        for name in cdf:
+            cdf[name].keep_column_major()
+    return cdf
+
+
+def _load(file_or_buffer, iso_8859_1_to_utf8, lazy_load, io_policy, variables):
     if type(file_or_buffer) is str:
-        return _pycdfpp.load(file_or_buffer, iso_8859_1_to_utf8, lazy_load)
+        if variables is not None:
+            return _pycdfpp.load(file_or_buffer, iso_8859_1_to_utf8, lazy_load, io_policy,
+                                 _make_variable_selector(variables))
+        return _pycdfpp.load(file_or_buffer, iso_8859_1_to_utf8, lazy_load, io_policy)
+    if variables is not None:
+        raise TypeError("variables selection is only supported when loading from a file")
     if lazy_load:
         return _pycdfpp.lazy_load(file_or_buffer, iso_8859_1_to_utf8)
     else:
@@ -40,6 +40,8 @@
 
 using namespace cdf;
 
+#include <pybind11/functional.h>
+#include <pybind11/native_enum.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 
@@ -271,15 +273,113 @@ void def_cdf_loading_functions(T& mod)
         py::arg("buffer"), py::arg("iso_8859_1_to_utf8") = false, py::return_value_policy::move,
         py::keep_alive<0, 1>());
 
+    py::native_enum<io::io_policy>(mod, "IOPolicy", "enum.Enum")
+        .value("automatic", io::io_policy::automatic)
+        .value("mmap", io::io_policy::mmap)
+        .value("mmap_sequential", io::io_policy::mmap_sequential)
+        .value("mmap_willneed", io::io_policy::mmap_willneed)
+        .value("mmap_populate", io::io_policy::mmap_populate)
+        .value("mmap_drop_behind", io::io_policy::mmap_drop_behind)
+        .value("pread", io::io_policy::pread)
+        .value("read_all", io::io_policy::read_all)
+        .value("direct", io::io_policy::direct)
+        .finalize();
+
     mod.def(
         "load",
-        [](const char* fname, bool iso_8859_1_to_utf8, bool lazy_load)
+        [](const char* fname, bool iso_8859_1_to_utf8, bool lazy_load, io::io_policy io_policy)
         {
             py::gil_scoped_release release;
-            return io::load(std::string { fname }, iso_8859_1_to_utf8, lazy_load);
+            return io::load(std::string { fname }, iso_8859_1_to_utf8, lazy_load, io_policy);
         },
         py::arg("fname"), py::arg("iso_8859_1_to_utf8") = false, py::arg("lazy_load") = true,
-        py::return_value_policy::move);
+        py::arg("io_policy") = io::io_policy::automatic, py::return_value_policy::move);
+
+    mod.def(
+        "load",
+        [](const char* fname, bool iso_8859_1_to_utf8, bool lazy_load, io::io_policy io_policy,
+            const std::vector<std::string>& variables)
+        {
+            py::gil_scoped_release release;
+            return io::load(
+                std::string { fname }, variables, iso_8859_1_to_utf8, lazy_load, io_policy);
+        },
+        py::arg("fname"), py::arg("iso_8859_1_to_utf8"), py::arg("lazy_load"),
+        py::arg("io_policy"), py::arg("variables"), py::return_value_policy::move);
+
+    mod.def(
+        "load",
+        [](const char* fname, bool iso_8859_1_to_utf8, bool lazy_load, io::io_policy io_policy,
+            const io::variable_selector& variables)
+        {
+            py::gil_scoped_release release;
+            return io::load(
+                std::string { fname }, variables, iso_8859_1_to_utf8, lazy_load, io_policy);
+        },
+        py::arg("fname"), py::arg("iso_8859_1_to_utf8"), py::arg("lazy_load"),
+        py::arg("io_policy"), py::arg("variables"), py::return_value_policy::move);
+
+    mod.def(
+        "load_many",
+        [](const std::vector<std::string>& fnames, const std::vector<std::string>& variables,
+            bool iso_8859_1_to_utf8, io::io_policy io_policy)
+        {
+            py::gil_scoped_release release;
+            return io::load_many(fnames, variables, iso_8859_1_to_utf8, io_policy);
+        },
+        py::arg("fnames"), py::arg("variables"), py::arg("iso_8859_1_to_utf8") = true,
+        py::arg("io_policy") = io::io_policy::automatic, py::return_value_policy::move,
+        R"(Loads the given variables from all files concurrently and concatenates record varying ones
+along records in files order, non record varying variables and attributes come from the first file.
+Returns None if a file can't be loaded.)");
+
+    mod.def(
+        "load_metadata",
+        [](const char* fname, bool iso_8859_1_to_utf8, io::io_policy io_policy)
+        {
+            py::gil_scoped_release release;
+            return io::load_metadata(std::string { fname }, iso_8859_1_to_utf8, io_policy);
+        },
+        py::arg("fname"), py::arg("iso_8859_1_to_utf8") = true,
+        py::arg("io_policy") = io::io_policy::automatic, py::return_value_policy::move);
+
+    mod.def(
+        "set_header_cache_directory", [](const std::string& directory)
+        { io::header_cache::set_directory(directory); }, py::arg("directory"),
+        R"(Caches parsed files structure in directory so lazy loads of already seen files skip
+parsing, an empty string disables the cache (default).)");
+    mod.def(
+        "header_cache_directory", []() { return io::header_cache::directory().string(); },
+        "Returns the header cache directory, empty when the cache is disabled");
+
+    mod.def("set_memory_budget", &memory_budget::set_budget, py::arg("bytes"),
+        R"(Sets the memory budget for lazily loaded variables values, in bytes. Once exceeded, the least
+recently accessed values are released and loaded again from the file on next access. 0 disables
+the budget (default).)");
+    mod.def("memory_budget", &memory_budget::budget, "Returns the memory budget in bytes, 0 if unset");
+    mod.def(
+        "memory_usage",
+        []()
+        {
+            const auto usage = memory_budget::usage();
+            py::dict result;
+            result["budget"] = usage.budget;
+            result["resident_bytes"] = usage.resident_bytes;
+            result["resident_count"] = usage.resident_count;
+            result["loads"] = usage.loads;
+            result["reloads"] = usage.reloads;
+            result["evictions"] = usage.evictions;
+            result["evicted_bytes"] = usage.evicted_bytes;
+            return result;
+        },
+        "Returns memory budget usage and loads/evictions counters as a dict");
+    mod.def("reset_memory_counters", &memory_budget::reset_counters,
+        "Resets memory budget loads and evictions counters");
+
+    mod.def("set_max_threads", &io::parallel::set_max_threads, py::arg("count"),
+        "Sets the maximum number of threads used to decode or compress variables, 0 means one per core");
+    mod.def("max_threads", &io::parallel::max_threads,
+        "Returns the maximum number of threads used to decode or compress variables");
 }
 
 struct cdf_bytes
@@ -293,12 +393,16 @@ void def_cdf_saving_functions(T& mod)
 
     mod.def(
         "save",
-        [](const CDF& cdf, const char* fname)
+        [](const CDF& cdf, const char* fname, std::size_t chunk_bytes, std::size_t chunk_records)
         {
             py::gil_scoped_release release;
-            return io::save(cdf, std::string { fname });
+            return io::save(cdf, std::string { fname },
+                io::chunk_policy_t { .target_bytes = chunk_bytes, .records = chunk_records });
         },
-        py::arg("cdf"), py::arg("fname"));
+        py::arg("cdf"), py::arg("fname"),
+        py::arg("chunk_bytes") = io::chunk_policy_t {}.target_bytes, py::arg("chunk_records") = 0UL,
+        R"(Saves cdf to fname. Values of compressed variables are split into CVVRs of about chunk_bytes
+uncompressed bytes, or chunk_records records when not 0. Smaller chunks give cheaper partial reads.)");
 
 
     py::class_<cdf_bytes>(mod, "_cdf_bytes", py::buffer_protocol())
@@ -311,10 +415,29 @@ void def_cdf_saving_functions(T& mod)
 
     mod.def(
         "save",
-        [](const CDF& cdf)
+        [](const CDF& cdf, std::size_t chunk_bytes, std::size_t chunk_records)
+        {
+            py::gil_scoped_release release;
+            return cdf_bytes { io::save(cdf,
+                io::chunk_policy_t { .target_bytes = chunk_bytes, .records = chunk_records }) };
+        },
+        py::arg("cdf"), py::arg("chunk_bytes") = io::chunk_policy_t {}.target_bytes,
+        py::arg("chunk_records") = 0UL,
+        "Saves cdf to a bytes like object, see save(cdf, fname, ...) for chunk_bytes and chunk_records");
+
+    mod.def(
+        "append",
+        [](const char* fname, const CDF& records, std::size_t chunk_bytes,
+            std::size_t chunk_records)
         {
             py::gil_scoped_release release;
-            return cdf_bytes { io::save(cdf) };
+            return io::append(std::string { fname }, records,
+                io::chunk_policy_t { .target_bytes = chunk_bytes, .records = chunk_records });
         },
-        py::arg("cdf"));
+        py::arg("fname"), py::arg("records"),
+        py::arg("chunk_bytes") = io::chunk_policy_t {}.target_bytes, py::arg("chunk_records") = 0UL,
+        R"(Appends the records of each variable of records to the variable with the same name in the
+existing v3 file fname, without rewriting the file. Returns False when fname isn't an uncompressed v3
+CDF file, raises ValueError when a variable is missing or has a different type or record shape.
+chunk_bytes and chunk_records split new records of compressed variables, see save.)");
 }
@@ -321,6 +321,12 @@ template <typename time_t>
 
 [[nodiscard]] inline py::object to_datetime64(const Variable& input)
 {
+    if (input.values_column_major())
+    {
+        auto row_major = input;
+        row_major.to_row_major();
+        return to_datetime64(row_major);
+    }
     using enum cdf::CDF_Types;
     auto result = _details::fast_allocate_array<uint64_t>(input.shape());
     auto out_ptr = static_cast<int64_t*>(result.request(true).ptr);
@@ -350,6 +356,12 @@ template <typename time_t>
 
 [[nodiscard]] py::list to_datetime(const Variable& input)
 {
+    if (input.values_column_major())
+    {
+        auto row_major = input;
+        row_major.to_row_major();
+        return to_datetime(row_major);
+    }
     using enum cdf::CDF_Types;
     switch (input.type())
     {
@@ -756,6 +768,12 @@ template <typename time_t>
 
 [[nodiscard]] py::array to_time_string(const Variable& input, const std::string& format)
 {
+    if (input.values_column_major())
+    {
+        auto row_major = input;
+        row_major.to_row_major();
+        return to_time_string(row_major, format);
+    }
     using enum cdf::CDF_Types;
     auto shape = _details::shape_ssize_t(input);
     const auto size = static_cast<std::size_t>(
@@ -162,6 +162,12 @@ template <typename T>
 template <typename T>
 [[nodiscard]] std::vector<ssize_t> strides(const Variable& var)
 {
+    // values kept in file order get Fortran strides inside records, see keep_column_major
+    if (var.values_column_major())
+    {
+        const auto strides = var.strides();
+        return std::vector<ssize_t>(std::cbegin(strides), std::cend(strides));
+    }
     const auto& shape = var.shape();
     std::vector<ssize_t> res(std::size(shape));
     std::transform(std::crbegin(shape), std::crend(shape), std::begin(res),
@@ -246,6 +252,36 @@ template <CDF_Types data_t>
 [[nodiscard]] py::array make_array(Variable& variable, py::object& obj)
 {
     // static_assert(data_t != CDF_Types::CDF_CHAR and data_t != CDF_Types::CDF_UCHAR);
+    {
+        py::gil_scoped_release release;
+        variable.load_values();
+    }
+    if (variable.values_budgeted())
+    {
+        // the array keeps values alive on its own since the budget may evict them at any load
+        auto values = [&variable]()
+        {
+            py::gil_scoped_release release;
+            return variable.budgeted_values();
+        }();
+        const auto* ptr = reinterpret_cast<const from_cdf_type_t<data_t>*>(values->bytes_ptr());
+        auto owner = py::capsule(new std::shared_ptr<const cdf::data_t>(std::move(values)),
+            [](void* p) { delete reinterpret_cast<std::shared_ptr<const cdf::data_t>*>(p); });
+        auto array = py::array_t<from_cdf_type_t<data_t>>(
+            shape_ssize_t(variable), strides<from_cdf_type_t<data_t>>(variable), ptr, owner);
+        array.attr("setflags")(py::arg("write") = false);
+        return array;
+    }
+    if (variable.values_mapped())
+    {
+        // values live in the mapped file, expose them read-only instead of copying them
+        auto array = py::array_t<from_cdf_type_t<data_t>>(shape_ssize_t(variable),
+            strides<from_cdf_type_t<data_t>>(variable),
+            reinterpret_cast<const from_cdf_type_t<data_t>*>(std::as_const(variable).bytes_ptr()),
+            obj);
+        array.attr("setflags")(py::arg("write") = false);
+        return array;
+    }
     from_cdf_type_t<data_t>* ptr = nullptr;
     {
         py::gil_scoped_release release;
@@ -312,7 +348,8 @@ template <CDF_Types T>
     char* ptr = nullptr;
     {
         py::gil_scoped_release release;
-        ptr = var.bytes_ptr();
+        // buffers are exported read-only, no need to copy mapped values
+        ptr = const_cast<char*>(std::as_const(var).bytes_ptr());
     }
     if constexpr ((T == CDF_Types::CDF_CHAR) or (T == CDF_Types::CDF_UCHAR))
     {
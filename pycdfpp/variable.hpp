@@ -68,9 +68,15 @@ type: DataType
 shape: List[int]
     variable shape (records + record shape)
 majority: cdf_majority
-    variable majority as writen in the CDF file, note that pycdfpp will always expose row major data.
+    variable majority as writen in the CDF file, note that pycdfpp will always expose row major data unless `keep_column_major` was called.
 values_loaded: bool
     True if values are availbale in memory, this is usefull with lazy loading to know if values are already loaded.
+values_mapped: bool
+    True if values are read directly from the memory mapped file, in that case `values` returns a read-only view.
+values_budgeted: bool
+    True if values count in the memory budget (see `set_memory_budget`), in that case `values` returns a read-only view.
+values_column_major: bool
+    True if values are kept in file column major order (see `keep_column_major`), in that case `values` returns an array with Fortran order strides inside records.
 compression: CompressionType
     variable compression type (supported values are no_compression, rle_compression, gzip_compression)
 values: numpy.array
@@ -82,6 +88,8 @@ Methods
 -------
 add_attribute
     Adds an attribute to the variable. Raises an exception if the attribute already exists.
+keep_column_major
+    Keeps values of a column major variable in file order instead of transposing them, returns True when values are kept in file order. Only applies to lazy, not yet loaded, non string variables with more than one dimension per record.
 set_compression_type
     Sets the variable compression type
 set_values
@@ -596,10 +604,47 @@ void def_variable_wrapper(T& mod)
         .def_property_readonly("majority", &Variable::majority)
         .def_property_readonly("is_nrv", &Variable::is_nrv)
         .def_property_readonly("values_loaded", &Variable::values_loaded)
+        .def_property_readonly("values_mapped", &Variable::values_mapped)
+        .def_property_readonly("values_budgeted", &Variable::values_budgeted)
+        .def_property_readonly("values_column_major", &Variable::values_column_major)
+        .def("keep_column_major", &Variable::keep_column_major)
         .def_property("compression", &Variable::compression_type, &Variable::set_compression_type)
         .def_buffer([](Variable& var) -> py::buffer_info { return make_buffer(var); })
         .def_property_readonly("values", make_values_view<false>, py::keep_alive<0, 1>())
         .def_property_readonly("values_encoded", make_values_view<true>, py::keep_alive<0, 1>())
+        .def(
+            "load_records",
+            [](const Variable& var, std::size_t first, std::size_t last)
+            {
+                py::gil_scoped_release release;
+                return var.load_records(first, last);
+            },
+            py::arg("first"), py::arg("last"),
+            "Returns a new Variable with records [first, last), only the needed blocks are read "
+            "from the file when values are not loaded yet")
+        .def("__getitem__",
+            [](const Variable& var, const py::slice& slice) -> py::object
+            {
+                std::size_t start = 0, stop = 0, step = 0, count = 0;
+                if (not slice.compute(var.len(), &start, &stop, &step, &count))
+                    throw py::error_already_set();
+                const auto sstep = static_cast<ssize_t>(step);
+                const auto last_index
+                    = static_cast<ssize_t>(start) + (static_cast<ssize_t>(count) - 1) * sstep;
+                const auto first = count ? std::min(static_cast<ssize_t>(start), last_index) : 0;
+                const auto last = count ? std::max(static_cast<ssize_t>(start), last_index) + 1 : 0;
+                py::object records = py::cast([&]()
+                    {
+                        py::gil_scoped_release release;
+                        return var.load_records(static_cast<std::size_t>(first),
+                            static_cast<std::size_t>(last));
+                    }());
+                auto values = make_values_view<false>(records);
+                if (sstep == 1)
+                    return values;
+                return values[py::module_::import("builtins")
+                        .attr("slice")(static_cast<ssize_t>(start) - first, py::none(), sstep)];
+            })
         .def(
             "_set_values",
             [](Variable& var, const py::array& values, std::optional<CDF_Types> data_type,
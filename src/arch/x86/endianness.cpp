@@ -0,0 +1,23 @@
+#include <cdfpp/vectorized/endianness-impl.hpp>
+
+namespace cdf::endianness::vectorized
+{
+
+auto _disp_byte_swap = xsimd::dispatch<CDFPP_XSIMD_ARCH_LIST>(_byte_swap_t {});
+
+} // namespace cdf::endianness::vectorized
+
+void vectorized_byte_swap(uint16_t* const data, std::size_t size)
+{
+    cdf::endianness::vectorized::_disp_byte_swap(data, size);
+}
+
+void vectorized_byte_swap(uint32_t* const data, std::size_t size)
+{
+    cdf::endianness::vectorized::_disp_byte_swap(data, size);
+}
+
+void vectorized_byte_swap(uint64_t* const data, std::size_t size)
+{
+    cdf::endianness::vectorized::_disp_byte_swap(data, size);
+}
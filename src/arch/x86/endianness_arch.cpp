@@ -0,0 +1,10 @@
+#include <cdfpp/vectorized/endianness-impl.hpp>
+
+namespace cdf::endianness::vectorized
+{
+
+template void _byte_swap_t::operator()<xsimd::CDFPP_ARCH>(xsimd::CDFPP_ARCH, uint16_t* const data, std::size_t size);
+template void _byte_swap_t::operator()<xsimd::CDFPP_ARCH>(xsimd::CDFPP_ARCH, uint32_t* const data, std::size_t size);
+template void _byte_swap_t::operator()<xsimd::CDFPP_ARCH>(xsimd::CDFPP_ARCH, uint64_t* const data, std::size_t size);
+
+} // namespace cdf::endianness::vectorized
@@ -0,0 +1,25 @@
+#include <cdfpp/vectorized/utf8-impl.hpp>
+
+namespace cdf::utf8::vectorized
+{
+
+auto _disp_is_valid_utf8 = xsimd::dispatch<CDFPP_XSIMD_ARCH_LIST>(_is_valid_utf8_t {});
+auto _disp_latin1_utf8_size = xsimd::dispatch<CDFPP_XSIMD_ARCH_LIST>(_latin1_utf8_size_t {});
+auto _disp_latin1_to_utf8 = xsimd::dispatch<CDFPP_XSIMD_ARCH_LIST>(_latin1_to_utf8_t {});
+
+} // namespace cdf::utf8::vectorized
+
+bool vectorized_is_valid_utf8(const char* const data, std::size_t size)
+{
+    return cdf::utf8::vectorized::_disp_is_valid_utf8(data, size);
+}
+
+std::size_t vectorized_latin1_utf8_size(const char* const data, std::size_t size)
+{
+    return cdf::utf8::vectorized::_disp_latin1_utf8_size(data, size);
+}
+
+void vectorized_latin1_to_utf8(const char* const data, std::size_t size, char* out)
+{
+    cdf::utf8::vectorized::_disp_latin1_to_utf8(data, size, out);
+}
@@ -0,0 +1,10 @@
+#include <cdfpp/vectorized/utf8-impl.hpp>
+
+namespace cdf::utf8::vectorized
+{
+
+template bool _is_valid_utf8_t::operator()<xsimd::CDFPP_ARCH>(xsimd::CDFPP_ARCH, const char* const data, std::size_t size);
+template std::size_t _latin1_utf8_size_t::operator()<xsimd::CDFPP_ARCH>(xsimd::CDFPP_ARCH, const char* const data, std::size_t size);
+template void _latin1_to_utf8_t::operator()<xsimd::CDFPP_ARCH>(xsimd::CDFPP_ARCH, const char* const data, std::size_t size, char* out);
+
+} // namespace cdf::utf8::vectorized
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+#include "tests_config.hpp"
+
+#include "cdfpp/cdf-file.hpp"
+#include "cdfpp/cdf-io/cdf-io.hpp"
+#include "cdfpp/variable.hpp"
+
+using namespace cdf;
+
+namespace
+{
+
+template <typename T>
+no_init_vector<T> counter(std::size_t size, T start)
+{
+    no_init_vector<T> values(size);
+    std::generate(std::begin(values), std::end(values), [v = start]() mutable { return v++; });
+    return values;
+}
+
+Variable make_variable(const std::string& name, std::size_t number, std::size_t records,
+    double start, cdf_compression_type compression = cdf_compression_type::no_compression)
+{
+    Variable v { name, number,
+        data_t { counter<double>(records * 3, start), CDF_Types::CDF_DOUBLE },
+        { static_cast<uint32_t>(records), 3 } };
+    v.set_compression_type(compression);
+    return v;
+}
+
+bool is_concatenation(const Variable& v, const Variable& head, const Variable& tail)
+{
+    return v.type() == head.type() and v.len() == head.len() + tail.len()
+        and v.bytes() == head.bytes() + tail.bytes()
+        and std::memcmp(v.bytes_ptr(), head.bytes_ptr(), head.bytes()) == 0
+        and std::memcmp(v.bytes_ptr() + head.bytes(), tail.bytes_ptr(), tail.bytes()) == 0;
+}
+
+std::string temporary_copy(const std::string& source, const std::string& name)
+{
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::copy_file(source, path, std::filesystem::copy_options::overwrite_existing);
+    return path.string();
+}
+
+}
+
+SCENARIO("Appending records to a file saved by CDFpp", "[CDF]")
+{
+    GIVEN("a file with uncompressed and compressed variables")
+    {
+        CDF cdf_obj;
+        cdf_obj.variables.emplace("raw", make_variable("raw", 0, 1000, 0.));
+        cdf_obj.variables.emplace(
+            "gzip", make_variable("gzip", 1, 1000, 0., cdf_compression_type::gzip_compression));
+        cdf_obj.variables.emplace(
+            "rle", make_variable("rle", 2, 1000, 0., cdf_compression_type::rle_compression));
+        cdf_obj.variables.emplace("constant",
+            Variable { "constant", 3, data_t { counter<double>(3, 0.), CDF_Types::CDF_DOUBLE },
+                { 1, 3 }, cdf_majority::row, true });
+        const auto path
+            = (std::filesystem::temp_directory_path() / "cdfpp-append-test.cdf").string();
+        REQUIRE(io::save(cdf_obj, path));
+        const auto initial_size = std::filesystem::file_size(path);
+
+        CDF records;
+        records.variables.emplace("raw", make_variable("raw", 0, 500, 3000.));
+        records.variables.emplace(
+            "gzip", make_variable("gzip", 1, 500, 3000., cdf_compression_type::gzip_compression));
+        records.variables.emplace(
+            "rle", make_variable("rle", 2, 500, 3000., cdf_compression_type::rle_compression));
+
+        WHEN("appending records to its variables")
+        {
+            REQUIRE(io::append(path, records, io::chunk_policy_t { .records = 100 }));
+            THEN("the file only grows by the appended records")
+            {
+                const auto appended_bytes = 3 * records.variables["raw"].bytes();
+                REQUIRE(std::filesystem::file_size(path) - initial_size < appended_bytes);
+            }
+            THEN("variables hold both old and new records")
+            {
+                auto loaded = io::load(path, true, false);
+                REQUIRE(loaded != std::nullopt);
+                for (const auto& name : { "raw", "gzip", "rle" })
+                {
+                    REQUIRE(is_concatenation(loaded->variables[name], cdf_obj.variables[name],
+                        records.variables[name]));
+                    REQUIRE(loaded->variables[name].compression_type()
+                        == cdf_obj.variables[name].compression_type());
+                }
+                REQUIRE(loaded->variables["constant"] == cdf_obj.variables["constant"]);
+            }
+            AND_WHEN("appending more records")
+            {
+                CDF more;
+                more.variables.emplace("raw", make_variable("raw", 0, 10, 4500.));
+                more.variables.emplace("gzip",
+                    make_variable("gzip", 1, 10, 4500., cdf_compression_type::gzip_compression));
+                REQUIRE(io::append(path, more));
+                THEN("new records follow the previously appended ones")
+                {
+                    auto loaded = io::load(path, true, true);
+                    REQUIRE(loaded != std::nullopt);
+                    const auto expected = make_variable("raw", 0, 1510, 0.);
+                    REQUIRE(loaded->variables["raw"].shape() == expected.shape());
+                    REQUIRE(loaded->variables["raw"].get<double>() == expected.get<double>());
+                    REQUIRE(loaded->variables["gzip"].get<double>() == expected.get<double>());
+                    const auto slice = loaded->variables["gzip"].load_records(990, 1505);
+                    REQUIRE(std::equal(std::cbegin(slice.get<double>()),
+                        std::cend(slice.get<double>()),
+                        std::cbegin(expected.get<double>()) + 990 * 3));
+                    REQUIRE(loaded->variables["rle"].len() == 1500);
+                }
+            }
+        }
+        WHEN("a variable is missing from the file")
+        {
+            records.variables.emplace("missing", make_variable("missing", 4, 10, 0.));
+            THEN("append throws and leaves the file untouched")
+            {
+                REQUIRE_THROWS_AS(io::append(path, records), std::invalid_argument);
+                REQUIRE(std::filesystem::file_size(path) == initial_size);
+            }
+        }
+        WHEN("records type or shape differ from the file")
+        {
+            CDF wrong_type;
+            wrong_type.variables.emplace("raw",
+                Variable { "raw", 0, data_t { counter<float>(30, 0.f), CDF_Types::CDF_FLOAT },
+                    { 10, 3 } });
+            CDF wrong_shape;
+            wrong_shape.variables.emplace("raw",
+                Variable { "raw", 0, data_t { counter<double>(40, 0.), CDF_Types::CDF_DOUBLE },
+                    { 10, 4 } });
+            CDF non_record_varying;
+            non_record_varying.variables.emplace("constant", make_variable("constant", 3, 1, 0.));
+            THEN("append throws")
+            {
+                REQUIRE_THROWS_AS(io::append(path, wrong_type), std::invalid_argument);
+                REQUIRE_THROWS_AS(io::append(path, wrong_shape), std::invalid_argument);
+                REQUIRE_THROWS_AS(io::append(path, non_record_varying), std::invalid_argument);
+                REQUIRE(std::filesystem::file_size(path) == initial_size);
+            }
+        }
+    }
+}
+
+SCENARIO("Appending records to existing files", "[CDF]")
+{
+    GIVEN("a column major file")
+    {
+        const auto path = temporary_copy(
+            std::string(DATA_PATH) + "/a_col_major_cdf.cdf", "cdfpp-append-col.cdf");
+        const auto original = io::load(path, true, false);
+        REQUIRE(original != std::nullopt);
+        const auto row_major = io::load(std::string(DATA_PATH) + "/a_cdf.cdf", true, false);
+        REQUIRE(row_major != std::nullopt);
+        CDF records;
+        for (const auto& name : { "var", "var3d", "var3d_counter", "var5d_counter", "epoch16" })
+            records.variables.emplace(name, row_major->variables[name]);
+        WHEN("appending row major records")
+        {
+            REQUIRE(io::append(path, records));
+            THEN("they are transposed to the file majority")
+            {
+                auto loaded = io::load(path, true, false);
+                REQUIRE(loaded != std::nullopt);
+                for (const auto& [name, variable] : records.variables)
+                    REQUIRE(is_concatenation(
+                        loaded->variables[name], original->variables[name], variable));
+            }
+        }
+    }
+    GIVEN("a file with compressed variables written by the CDF library")
+    {
+        const auto path = temporary_copy(
+            std::string(DATA_PATH) + "/a_cdf_with_compressed_vars.cdf", "cdfpp-append-comp.cdf");
+        const auto original = io::load(path, true, false);
+        REQUIRE(original != std::nullopt);
+        CDF records;
+        for (const auto& name : { "var", "zeros", "var2d_counter", "var_recvary_string" })
+            records.variables.emplace(name, original->variables[name]);
+        WHEN("appending records to them")
+        {
+            REQUIRE(io::append(path, records));
+            THEN("they load back after the existing ones")
+            {
+                auto loaded = io::load(path, true, false);
+                REQUIRE(loaded != std::nullopt);
+                for (const auto& [name, variable] : records.variables)
+                    REQUIRE(is_concatenation(loaded->variables[name], variable, variable));
+                REQUIRE(loaded->variables["var3d"] == original->variables["var3d"]);
+            }
+        }
+    }
+    GIVEN("files that can't be appended to")
+    {
+        const auto compressed = temporary_copy(
+            std::string(DATA_PATH) + "/a_compressed_cdf.cdf", "cdfpp-append-gz.cdf");
+        const auto not_a_cdf = temporary_copy(
+            std::string(DATA_PATH) + "/not_a_cdf.cdf", "cdfpp-append-not-cdf.cdf");
+        CDF records;
+        records.variables.emplace("var", make_variable("var", 0, 10, 0.));
+        THEN("append returns false")
+        {
+            REQUIRE_FALSE(io::append(compressed, records));
+            REQUIRE_FALSE(io::append(not_a_cdf, records));
+        }
+    }
+}
@@ -3,6 +3,8 @@
 
 #include "cdfpp/cdf-io/endianness.hpp"
 #include <cstdint>
+#include <numeric>
+#include <vector>
 
 
 TEST_CASE("", "")
@@ -13,3 +15,30 @@ TEST_CASE("", "")
     REQUIRE(0x01020304 == decode<big_endian_t, uint32_t>("\1\2\3\4"));
     REQUIRE(0x0102030405060701 == decode<big_endian_t, uint64_t>("\1\2\3\4\5\6\7\1"));
 }
+
+template <typename T>
+bool decode_v_matches_decode(std::size_t size)
+{
+    using namespace cdf::endianness;
+    std::vector<T> values(size);
+    std::iota(std::begin(values), std::end(values), T { 1 });
+    auto swapped = values;
+    decode_v<big_endian_t>(swapped.data(), size);
+    for (auto i = 0UL; i < size; i++)
+    {
+        if (swapped[i] != decode<big_endian_t, T>(values.data() + i))
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE("decode_v matches decode on arrays of any size", "")
+{
+    for (auto size : { 1UL, 63UL, 64UL, 65UL, 1000UL, 4099UL })
+    {
+        REQUIRE(decode_v_matches_decode<uint16_t>(size));
+        REQUIRE(decode_v_matches_decode<uint32_t>(size));
+        REQUIRE(decode_v_matches_decode<uint64_t>(size));
+        REQUIRE(decode_v_matches_decode<double>(size));
+    }
+}
@@ -3,6 +3,7 @@
 
 #include "cdfpp/cdf-io/majority-swap.hpp"
 #include "vector"
+#include <numeric>
 
 
 SCENARIO("Generating flat indexes")
@@ -118,3 +119,39 @@ SCENARIO("Swapping from col to row major", "[CDF]")
         }
     }
 }
+
+SCENARIO("Swapping records of any rank from col to row major", "[CDF]")
+{
+    GIVEN("column major arrays")
+    {
+        auto shape = GENERATE(std::vector<std::size_t> { 7, 3, 5 },
+            std::vector<std::size_t> { 3, 33, 17 }, std::vector<std::size_t> { 2, 100, 70 },
+            std::vector<std::size_t> { 5, 2, 3, 4 }, std::vector<std::size_t> { 2, 40, 3, 70 },
+            std::vector<std::size_t> { 2, 3, 4, 5, 6 });
+        const std::vector<std::size_t> record_shape(std::cbegin(shape) + 1, std::cend(shape));
+        const auto record_size = std::accumulate(std::cbegin(record_shape),
+            std::cend(record_shape), 1UL, std::multiplies<std::size_t>());
+        std::vector<double> input(shape[0] * record_size);
+        std::iota(std::begin(input), std::end(input), 0.);
+        WHEN("Swapping to row major")
+        {
+            auto output = input;
+            cdf::majority::swap<false>(output, shape);
+            THEN("each element moved to its row major position")
+            {
+                std::vector<std::size_t> index(std::size(record_shape), 0UL);
+                for (auto record = 0UL; record < shape[0]; record++)
+                {
+                    for (auto i = 0UL; i < record_size; i++)
+                    {
+                        REQUIRE(output[record * record_size
+                                    + cdf::majority::inverted_flat_index(index, record_shape)]
+                            == input[record * record_size
+                                + cdf::majority::flat_index(index, record_shape)]);
+                        cdf::majority::_private::next_index(index, record_shape);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -189,3 +189,78 @@ SCENARIO("nomap", "[CDF]")
         }
     }
 }
+
+SCENARIO("large nomap lookups go through the hash index", "[CDF][nomap]")
+{
+    GIVEN("a nomap with many keys")
+    {
+        nomap<std::string, int> map;
+        std::vector<std::string> keys;
+        for (int i = 0; i < 1000; i++)
+        {
+            keys.push_back("key_" + std::to_string(i));
+            map[keys.back()] = i;
+        }
+        THEN("every key is found and insertion order is kept")
+        {
+            REQUIRE(map.size() == 1000);
+            for (int i = 0; i < 1000; i++)
+                REQUIRE(map.at(keys[i]) == i);
+            int i = 0;
+            for (const auto& [key, value] : map)
+                REQUIRE(key == keys[i++]);
+            REQUIRE(map.count("not a key") == 0);
+            REQUIRE_THROWS_AS(map.at("not a key"), std::out_of_range);
+        }
+        WHEN("erasing and extracting keys")
+        {
+            std::unordered_map<std::string, int> ref;
+            for (int i = 0; i < 1000; i++)
+                ref[keys[i]] = i;
+            for (int i = 0; i < 1000; i += 3)
+            {
+                map.erase(map.find(keys[i]));
+                ref.erase(keys[i]);
+            }
+            for (int i = 1; i < 1000; i += 7)
+            {
+                if (ref.erase(keys[i]))
+                    REQUIRE(map.extract(keys[i]).second == i);
+            }
+            map.erase(map.cbegin() + 10, map.cbegin() + 20);
+            THEN("remaining keys are still found and removed ones are not")
+            {
+                std::size_t kept = 0;
+                for (int i = 0; i < 1000; i++)
+                {
+                    const auto it = map.find(keys[i]);
+                    if (it != map.end())
+                    {
+                        REQUIRE(ref.at(keys[i]) == it->second);
+                        kept++;
+                    }
+                }
+                REQUIRE(kept == map.size());
+                REQUIRE(map.size() == ref.size() - 10);
+            }
+            THEN("new keys can still be added")
+            {
+                map["new key"] = -1;
+                REQUIRE(map.at("new key") == -1);
+                REQUIRE(map.at(keys[2]) == 2);
+            }
+        }
+        WHEN("comparing with a copy built in another order")
+        {
+            nomap<std::string, int> other;
+            for (int i = 999; i >= 0; i--)
+                other[keys[i]] = i;
+            THEN("maps are equal")
+            {
+                REQUIRE(map == other);
+                other[keys[0]] = -1;
+                REQUIRE_FALSE(map == other);
+            }
+        }
+    }
+}
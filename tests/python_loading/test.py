@@ -4,6 +4,8 @@ import os
 from datetime import datetime, timedelta
 import numpy as np
 import math
+import re
+import tempfile
 import unittest
 from glob import glob
 import pycdfpp
@@ -214,6 +216,137 @@ class PycdfLazyLoadingTest(unittest.TestCase):
             data = [v.values for _, v in cdf.items()]
             self.assertTrue(all([d is not None for d in data]))
 
+    def test_records_slicing_matches_values(self):
+        files = glob(
+            f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_*.cdf')
+        for f in files:
+            cdf = pycdfpp.load(f)
+            ref = pycdfpp.load(f, lazy_load=False)
+            for name, v in cdf.items():
+                if v.type in (pycdfpp.DataType.CDF_CHAR, pycdfpp.DataType.CDF_UCHAR):
+                    continue
+                n = len(v)
+                for s in (slice(None), slice(n // 3, n // 2 + 1), slice(1, None, 2),
+                          slice(None, None, -3), slice(n, n + 10)):
+                    np.testing.assert_array_equal(v[s], ref[name].values[s])
+                self.assertFalse(v.values_loaded)
+
+    def test_mapped_values_are_read_only_views(self):
+        f = f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_cdf.cdf'
+        cdf = pycdfpp.load(f)
+        ref = pycdfpp.load(load_bytes(f))
+        mapped = [name for name, v in cdf.items() if v.values is not None and v.values_mapped]
+        self.assertTrue(len(mapped) > 0)
+        for name in mapped:
+            values = cdf[name].values
+            self.assertFalse(values.flags.writeable)
+            np.testing.assert_array_equal(values, ref[name].values)
+
+    def test_multithreaded_loading(self):
+        files = glob(
+            f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_*.cdf')
+        for f in files:
+            ref = pycdfpp.load(f, lazy_load=False)
+            pycdfpp.set_max_threads(4)
+            try:
+                self.assertEqual(pycdfpp.max_threads(), 4)
+                self.assertEqual(pycdfpp.load(f, lazy_load=False), ref)
+            finally:
+                pycdfpp.set_max_threads(1)
+
+    def test_metadata_only_loading(self):
+        files = glob(
+            f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_*.cdf')
+        for f in files:
+            ref = pycdfpp.load(f, lazy_load=False)
+            cdf = pycdfpp.load_metadata(f)
+            self.assertEqual(list(cdf.attributes.keys()), list(ref.attributes.keys()))
+            for name, var in cdf.items():
+                self.assertEqual(var.type, ref[name].type)
+                self.assertEqual(var.shape, ref[name].shape)
+            self.assertEqual(cdf, ref)
+
+    def test_load_time_variables_selection(self):
+        f = f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_cdf.cdf'
+        ref = pycdfpp.load(f, lazy_load=False)
+        names = list(ref.keys())[:3]
+        pattern = '(' + '|'.join(map(re.escape, names)) + ')$'
+        for selection in (names, pattern, re.compile(pattern), lambda name: name in names):
+            for lazy in (True, False):
+                cdf = pycdfpp.load(f, lazy_load=lazy, variables=selection)
+                self.assertEqual(sorted(cdf.keys()), sorted(names))
+                for name in names:
+                    self.assertEqual(cdf[name], ref[name])
+
+    def test_load_many_concatenates_variables(self):
+        f = f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_cdf.cdf'
+        ref = pycdfpp.load(f, lazy_load=False)
+        names = list(ref.keys())
+        cdf = pycdfpp.load_many([f, f], names)
+        for name in names:
+            if ref[name].is_nrv:
+                self.assertEqual(cdf[name], ref[name])
+            else:
+                self.assertTrue(np.array_equal(cdf[name].values, np.concatenate(
+                    [ref[name].values, ref[name].values]), equal_nan=ref[name].values.dtype.kind == 'f'))
+        self.assertIsNone(pycdfpp.load_many([f, f + '.missing'], names))
+
+    def test_header_cache_gives_the_same_result(self):
+        f = f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_cdf.cdf'
+        ref = pycdfpp.load(f)
+        with tempfile.TemporaryDirectory() as cache_dir:
+            pycdfpp.set_header_cache_directory(cache_dir)
+            try:
+                self.assertEqual(pycdfpp.header_cache_directory(), cache_dir)
+                self.assertEqual(pycdfpp.load(f), ref)
+                self.assertEqual(len(os.listdir(cache_dir)), 1)
+                self.assertEqual(pycdfpp.load(f), ref)
+            finally:
+                pycdfpp.set_header_cache_directory('')
+        self.assertEqual(pycdfpp.header_cache_directory(), '')
+
+    def test_memory_budget_evicts_least_recently_used_values(self):
+        f = f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_col_major_cdf.cdf'
+        ref = pycdfpp.load(f, lazy_load=False)
+        cdf = pycdfpp.load(f)
+        pycdfpp.reset_memory_counters()
+        pycdfpp.set_memory_budget(1)
+        try:
+            self.assertEqual(pycdfpp.memory_budget(), 1)
+            views = {name: cdf[name].values for name in ref.keys()
+                     if ref[name].type in (pycdfpp.DataType.CDF_DOUBLE, pycdfpp.DataType.CDF_BYTE)}
+            usage = pycdfpp.memory_usage()
+            self.assertEqual(usage['resident_count'], 1)
+            self.assertEqual(usage['evictions'], len(views) - 1)
+            for name, values in views.items():
+                self.assertTrue(cdf[name].values_budgeted)
+                self.assertFalse(values.flags.writeable)
+                self.assertTrue(np.array_equal(values, ref[name].values))
+        finally:
+            pycdfpp.set_memory_budget(0)
+
+    def test_column_major_values_kept_in_file_order(self):
+        f = f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_col_major_cdf.cdf'
+        ref = pycdfpp.load(f, lazy_load=False)
+        cdf = pycdfpp.load(f, keep_column_major=True)
+        kept = [name for name in ref.keys() if cdf[name].values_column_major]
+        self.assertNotEqual(len(kept), 0)
+        for name in kept:
+            values = cdf[name].values
+            self.assertEqual(values.shape, ref[name].values.shape)
+            self.assertTrue(values[0].flags.f_contiguous)
+            self.assertEqual(values.strides[1], values.itemsize)
+            self.assertTrue(np.array_equal(values, ref[name].values))
+
+    def test_every_io_policy_gives_the_same_result(self):
+        files = glob(
+            f'{os.path.dirname(os.path.abspath(__file__))}/../resources/a_*.cdf')
+        for f in files:
+            ref = pycdfpp.load(f, lazy_load=False, io_policy=pycdfpp.IOPolicy.mmap)
+            for policy in pycdfpp.IOPolicy:
+                for lazy in (True, False):
+                    self.assertEqual(pycdfpp.load(f, lazy_load=lazy, io_policy=policy), ref)
+
 
 class PycdfDatetimeReprTest(unittest.TestCase):
     def test_can_repr_the_exact_expected_value_no_matter_what_TZ(self):
@@ -228,6 +228,35 @@ class PycdfCreateCDFTest(unittest.TestCase):
         self.assertEqual(reloaded_cdf["test"].shape, (0,))
         self.assertEqual(reloaded_cdf["test"].compression, pycdfpp.CompressionType.gzip_compression)
 
+    def test_can_save_compressed_vars_with_a_chunk_size(self):
+        cdf = pycdfpp.CDF()
+        values = np.cos(np.arange(30000, dtype=np.float64) * 0.01).reshape(10000, 3)
+        cdf.add_variable("test", values=values, compression=pycdfpp.CompressionType.gzip_compression)
+        single_chunk = bytes(pycdfpp.save(cdf))
+        for chunked in (bytes(pycdfpp.save(cdf, chunk_records=1000)),
+                        bytes(pycdfpp.save(cdf, chunk_bytes=1 << 10))):
+            self.assertGreater(len(chunked), len(single_chunk))
+            self.assertTrue(np.array_equal(pycdfpp.load(chunked)["test"].values, values))
+
+    def test_can_append_records_to_a_saved_file(self):
+        with NamedTemporaryFile() as f:
+            cdf = pycdfpp.CDF()
+            values = np.arange(30, dtype=np.float64).reshape(10, 3)
+            cdf.add_variable("raw", values=values)
+            cdf.add_variable("gzip", values=values, compression=pycdfpp.CompressionType.gzip_compression)
+            self.assertTrue(pycdfpp.save(cdf, f.name))
+            records = pycdfpp.CDF()
+            records.add_variable("raw", values=values + 30)
+            records.add_variable("gzip", values=values + 30)
+            self.assertTrue(pycdfpp.append(f.name, records))
+            reloaded_cdf = pycdfpp.load(f.name)
+            for name in ("raw", "gzip"):
+                self.assertTrue(np.array_equal(reloaded_cdf[name].values, np.arange(60).reshape(20, 3)))
+            missing = pycdfpp.CDF()
+            missing.add_variable("missing", values=values)
+            with self.assertRaises(ValueError):
+                pycdfpp.append(f.name, missing)
+
 
 if __name__ == '__main__':
     unittest.main()
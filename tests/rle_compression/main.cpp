@@ -84,3 +84,27 @@ TEST_CASE("inflate handles truncated input (zero byte at end)", "")
     REQUIRE(output[0] == 1);
     REQUIRE(output[1] == 2);
 }
+
+TEST_CASE("deflate and inflate round trip long literal and zero runs", "")
+{
+    // runs lengths around the word size and the 256 zeros run limit
+    for (const std::size_t literals : { 1UL, 7UL, 8UL, 9UL, 17UL, 300UL })
+    {
+        for (const std::size_t zeros : { 0UL, 1UL, 8UL, 255UL, 256UL, 257UL, 600UL })
+        {
+            no_init_vector<char> input;
+            for (std::size_t run = 0; run < 3; run++)
+            {
+                for (std::size_t i = 0; i < literals; i++)
+                    input.push_back(static_cast<char>(1 + (i + run) % 200));
+                input.insert(std::end(input), zeros, 0);
+            }
+            auto deflated = cdf::io::rle::deflate(input);
+            REQUIRE(std::size(deflated) <= std::size(input) + std::size(input) / 2 + 2);
+            no_init_vector<char> output(std::size(input));
+            REQUIRE(cdf::io::rle::inflate(deflated, output.data(), std::size(output))
+                == std::size(input));
+            REQUIRE(output == input);
+        }
+    }
+}
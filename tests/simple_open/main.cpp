@@ -1,7 +1,12 @@
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <optional>
+#include <regex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -596,3 +601,702 @@ SCENARIO("Loading cdf files", "[CDF]")
         }
     }
 }
+
+SCENARIO("Loading a range of records", "[CDF]")
+{
+    GIVEN("a cdf file")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_cdf.cdf", "a_compressed_cdf.cdf",
+            "a_cdf_with_compressed_vars.cdf", "a_col_major_cdf.cdf", "a_rle_compressed_cdf.cdf",
+            "ac_h2_sis_20101105_v06.cdf");
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto lazy_cd = cdf::io::load(path, true, true);
+        auto cd = cdf::io::load(path, true, false);
+        REQUIRE(lazy_cd != std::nullopt);
+        REQUIRE(cd != std::nullopt);
+        WHEN("loading a slice of records of each variable")
+        {
+            THEN("they match the same slice of the fully loaded variable")
+            {
+                for (const auto& [name, var] : lazy_cd->variables)
+                {
+                    const auto& ref = cd->variables[name];
+                    const auto len = ref.len();
+                    for (const auto& [first, last] :
+                        { std::pair<std::size_t, std::size_t> { 0UL, len },
+                            { len / 3, len / 2 + 1 }, { len / 2, len + 10 }, { len, len } })
+                    {
+                        const auto slice = var.load_records(first, last);
+                        const auto expected_len = std::min(last, len) - std::min(first, len);
+                        REQUIRE(slice.len() == expected_len);
+                        REQUIRE(slice.type() == ref.type());
+                        REQUIRE(slice.attributes == ref.attributes);
+                        if (expected_len)
+                        {
+                            const auto record_bytes = ref.bytes() / len;
+                            REQUIRE(slice.bytes() == expected_len * record_bytes);
+                            REQUIRE(std::memcmp(slice.bytes_ptr(),
+                                        ref.bytes_ptr() + first * record_bytes, slice.bytes())
+                                == 0);
+                        }
+                    }
+                    REQUIRE_FALSE(var.values_loaded());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Loading compressed variables with several threads", "[CDF]")
+{
+    GIVEN("a cdf file with compressed variables")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_compressed_cdf.cdf",
+            "a_cdf_with_compressed_vars.cdf", "a_rle_compressed_cdf.cdf");
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        cdf::io::parallel::set_max_threads(1);
+        auto ref = cdf::io::load(path, true, false);
+        REQUIRE(ref != std::nullopt);
+        WHEN("loading it with 4 threads")
+        {
+            cdf::io::parallel::set_max_threads(4);
+            auto cd = cdf::io::load(path, true, false);
+            cdf::io::parallel::set_max_threads(1);
+            THEN("variables values are the same")
+            {
+                REQUIRE(cd != std::nullopt);
+                REQUIRE(*cd == *ref);
+            }
+        }
+    }
+}
+
+SCENARIO("Eager loading of all variables with several threads", "[CDF]")
+{
+    GIVEN("a cdf file")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_cdf.cdf", "a_col_major_cdf.cdf",
+            "a_cdf_with_compressed_vars.cdf", "ac_h2_sis_20101105_v06.cdf");
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path, true, true);
+        REQUIRE(ref != std::nullopt);
+        WHEN("loading it eagerly with 4 threads")
+        {
+            cdf::io::parallel::set_max_threads(4);
+            auto cd = cdf::io::load(path, true, false);
+            cdf::io::parallel::set_max_threads(1);
+            THEN("it matches the lazily loaded one, variables order included")
+            {
+                REQUIRE(cd != std::nullopt);
+                REQUIRE(*cd == *ref);
+                REQUIRE(std::size(cd->variables) == std::size(ref->variables));
+                auto it = std::cbegin(ref->variables);
+                for (const auto& [name, var] : cd->variables)
+                {
+                    REQUIRE(name == (it++)->first);
+                    REQUIRE(var.values_loaded());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Values of uncompressed variables can be mapped from the file", "[CDF]")
+{
+    GIVEN("a row major uncompressed cdf file")
+    {
+        auto path = std::string(DATA_PATH) + "/a_cdf.cdf";
+        REQUIRE(file_exists(path));
+        auto lazy = cdf::io::load(path, true, true);
+        auto eager = cdf::io::load(path, true, false);
+        REQUIRE(lazy != std::nullopt);
+        REQUIRE(eager != std::nullopt);
+        auto ref = cdf::io::load(
+            [&]()
+            {
+                std::fstream file { path, std::ios::binary | std::ios::in };
+                std::vector<char> data(filesize(file));
+                file.read(data.data(), static_cast<int64_t>(std::size(data)));
+                return data;
+            }(),
+            true, false);
+        REQUIRE(ref != std::nullopt);
+        WHEN("loading values")
+        {
+            THEN("some variables are mapped and all match values loaded from memory")
+            {
+                std::size_t mapped = 0;
+                for (const auto& [name, var] : lazy->variables)
+                {
+                    var.load_values();
+                    mapped += var.values_mapped();
+                    REQUIRE(var == ref->variables[name]);
+                    REQUIRE(eager->variables[name] == ref->variables[name]);
+                    REQUIRE_FALSE(ref->variables[name].values_mapped());
+                }
+                REQUIRE(mapped > 0);
+            }
+            THEN("mapped values are copied on mutable access and outlive the CDF")
+            {
+                auto it = std::find_if(std::cbegin(lazy->variables), std::cend(lazy->variables),
+                    [](const auto& item)
+                    {
+                        item.second.load_values();
+                        return item.second.values_mapped()
+                            and item.second.type() == cdf::CDF_Types::CDF_DOUBLE;
+                    });
+                REQUIRE(it != std::cend(lazy->variables));
+                auto var = it->second;
+                lazy = std::nullopt;
+                REQUIRE(var.values_mapped());
+                const auto expected = ref->variables[var.name()].get<double>();
+                REQUIRE(var.get<double>() == expected);
+                REQUIRE_FALSE(var.values_mapped());
+                var.get<double>()[0] = 42.;
+                REQUIRE(var.get<double>()[0] == 42.);
+            }
+        }
+    }
+}
+
+#ifdef USE_MMAP
+SCENARIO("Loading a cdf file with pread and read-ahead", "[CDF]")
+{
+    GIVEN("a cdf file")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_cdf.cdf", "a_col_major_cdf.cdf",
+            "a_compressed_cdf.cdf", "a_cdf_with_compressed_vars.cdf");
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path, true, false);
+        REQUIRE(ref != std::nullopt);
+        WHEN("loading it with load_with_reads")
+        {
+            auto lazy = cdf::io::load_with_reads(path);
+            auto eager = cdf::io::load_with_reads(path, true, false);
+            THEN("it matches the mmap loaded one")
+            {
+                REQUIRE(lazy != std::nullopt);
+                REQUIRE(eager != std::nullopt);
+                REQUIRE(*lazy == *ref);
+                REQUIRE(*eager == *ref);
+                for (const auto& [name, var] : eager->variables)
+                    REQUIRE_FALSE(var.values_mapped());
+            }
+        }
+        WHEN("loading a missing file")
+        {
+            THEN("nothing is returned")
+            {
+                REQUIRE(cdf::io::load_with_reads(path + ".missing") == std::nullopt);
+            }
+        }
+    }
+}
+#endif
+
+SCENARIO("Loading a cdf file with every io policy", "[CDF]")
+{
+    GIVEN("a cdf file")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_cdf.cdf", "a_col_major_cdf.cdf",
+            "a_compressed_cdf.cdf", "ac_h2_sis_20101105_v06.cdf");
+        auto policy = GENERATE(cdf::io::io_policy::automatic, cdf::io::io_policy::mmap,
+            cdf::io::io_policy::mmap_sequential, cdf::io::io_policy::mmap_willneed,
+            cdf::io::io_policy::mmap_populate, cdf::io::io_policy::mmap_drop_behind,
+            cdf::io::io_policy::pread, cdf::io::io_policy::read_all, cdf::io::io_policy::direct);
+        auto lazy = GENERATE(true, false);
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path, true, false, cdf::io::io_policy::mmap);
+        REQUIRE(ref != std::nullopt);
+        WHEN("loading it")
+        {
+            auto cd = cdf::io::load(path, true, lazy, policy);
+            THEN("it matches the one loaded with mmap")
+            {
+                REQUIRE(cd != std::nullopt);
+                REQUIRE(*cd == *ref);
+            }
+        }
+        WHEN("loading a missing file")
+        {
+            THEN("nothing is returned")
+            {
+                REQUIRE(cdf::io::load(path + ".missing", true, lazy, policy) == std::nullopt);
+            }
+        }
+    }
+}
+
+SCENARIO("Loading only the metadata of a cdf file", "[CDF]")
+{
+    GIVEN("a cdf file")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_cdf.cdf", "a_col_major_cdf.cdf",
+            "a_compressed_cdf.cdf", "ac_h2_sis_20101105_v06.cdf", "testutf8.cdf",
+            "ge_k0_cpi_19921231_v02.cdf", "ia_k0_epi_19970102_v01.cdf");
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path, true, false);
+        REQUIRE(ref != std::nullopt);
+        WHEN("loading it with load_metadata")
+        {
+            auto cd = cdf::io::load_metadata(path);
+            REQUIRE(cd != std::nullopt);
+            THEN("structure is available without loading any value")
+            {
+                REQUIRE(std::size(cd->attributes) == std::size(ref->attributes));
+                REQUIRE(std::size(cd->variables) == std::size(ref->variables));
+                for (const auto& [name, attr] : cd->attributes)
+                    REQUIRE_FALSE(attr.values_loaded());
+                for (const auto& [name, var] : cd->variables)
+                {
+                    const auto& ref_var = ref->variables[name];
+                    REQUIRE_FALSE(var.values_loaded());
+                    REQUIRE(var.type() == ref_var.type());
+                    REQUIRE(var.shape() == ref_var.shape());
+                    REQUIRE(std::size(var.attributes) == std::size(ref_var.attributes));
+                    for (const auto& [attr_name, attr] : var.attributes)
+                    {
+                        REQUIRE_FALSE(attr.values_loaded());
+                        REQUIRE(attr.type() == ref_var.attributes[attr_name].type());
+                    }
+                }
+            }
+            THEN("attributes values are decoded on access and match a full load")
+            {
+                REQUIRE(cd->attributes == ref->attributes);
+                for (const auto& [name, attr] : cd->attributes)
+                    REQUIRE(attr.values_loaded());
+                for (const auto& [name, var] : cd->variables)
+                    REQUIRE(var.attributes == ref->variables[name].attributes);
+            }
+            THEN("attributes values can be decoded by several threads at once")
+            {
+                const auto& attributes = std::as_const(cd->attributes);
+                std::vector<std::thread> threads;
+                std::atomic<std::size_t> matching = 0UL;
+                for (auto i = 0; i < 4; i++)
+                    threads.emplace_back(
+                        [&]()
+                        {
+                            for (const auto& [name, attr] : attributes)
+                                matching += attr == std::as_const(ref->attributes).at(name);
+                        });
+                for (auto& thread : threads)
+                    thread.join();
+                REQUIRE(matching == 4 * std::size(attributes));
+                for (const auto& [name, attr] : attributes)
+                    REQUIRE(attr.values_loaded());
+            }
+        }
+    }
+}
+
+SCENARIO("Loading only some variables of a cdf file", "[CDF]")
+{
+    GIVEN("a cdf file")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_cdf.cdf", "a_compressed_cdf.cdf",
+            "ac_h2_sis_20101105_v06.cdf", "ge_k0_cpi_19921231_v02.cdf");
+        auto lazy = GENERATE(true, false);
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path, true, false);
+        REQUIRE(ref != std::nullopt);
+        REQUIRE(std::size(ref->variables) >= 3);
+        std::vector<std::string> names;
+        for (const auto& [name, var] : ref->variables)
+            if (std::size(names) < 2 or name == (--std::cend(ref->variables))->first)
+                names.push_back(name);
+        auto check_selection = [&](const std::optional<cdf::CDF>& cd)
+        {
+            REQUIRE(cd != std::nullopt);
+            REQUIRE(std::size(cd->variables) == std::size(names));
+            REQUIRE(cd->attributes == ref->attributes);
+            for (const auto& name : names)
+            {
+                REQUIRE(cd->variables.count(name) == 1);
+                REQUIRE(cd->variables[name] == ref->variables[name]);
+            }
+        };
+        WHEN("selecting variables with a list of names")
+        {
+            auto cd = cdf::io::load(path, names, true, lazy);
+            THEN("only these variables are loaded, with their attributes")
+            {
+                check_selection(cd);
+            }
+        }
+        WHEN("selecting variables with a predicate")
+        {
+            auto cd = cdf::io::load(
+                path,
+                [&](const std::string& name)
+                { return std::find(std::cbegin(names), std::cend(names), name) != std::cend(names); },
+                true, lazy);
+            THEN("only these variables are loaded, with their attributes")
+            {
+                check_selection(cd);
+            }
+        }
+        WHEN("selecting variables with a regex")
+        {
+            std::string pattern;
+            for (const auto& name : names)
+                pattern += (std::empty(pattern) ? "" : "|") + std::regex_replace(name,
+                    std::regex { R"([.^$|()\[\]{}*+?\\])" }, R"(\$&)");
+            auto cd = cdf::io::load(path, std::regex { pattern }, true, lazy);
+            THEN("only these variables are loaded, with their attributes")
+            {
+                check_selection(cd);
+            }
+        }
+        WHEN("selecting no variable")
+        {
+            auto cd = cdf::io::load(path, std::vector<std::string> {}, true, lazy);
+            THEN("only global attributes are loaded")
+            {
+                REQUIRE(cd != std::nullopt);
+                REQUIRE(std::size(cd->variables) == 0);
+                REQUIRE(cd->attributes == ref->attributes);
+            }
+        }
+    }
+}
+
+SCENARIO("Loading and concatenating variables from several files", "[CDF]")
+{
+    GIVEN("several copies of the same cdf file")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_cdf.cdf", "a_col_major_cdf.cdf",
+            "a_compressed_cdf.cdf", "a_cdf_with_compressed_vars.cdf");
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path, true, false);
+        REQUIRE(ref != std::nullopt);
+        std::vector<std::string> names;
+        for (const auto& [name, var] : ref->variables)
+            names.push_back(name);
+        const std::vector<std::string> paths { path, path, path };
+        WHEN("loading all variables with load_many")
+        {
+            cdf::io::parallel::set_max_threads(3);
+            auto cd = cdf::io::load_many(paths, names);
+            cdf::io::parallel::set_max_threads(1);
+            THEN("record varying variables are concatenated, others are left as is")
+            {
+                REQUIRE(cd != std::nullopt);
+                REQUIRE(cd->attributes == ref->attributes);
+                REQUIRE(std::size(cd->variables) == std::size(names));
+                for (const auto& [name, var] : ref->variables)
+                {
+                    const auto& result = cd->variables[name];
+                    REQUIRE(result.type() == var.type());
+                    REQUIRE(result.attributes == var.attributes);
+                    if (var.is_nrv() or std::empty(var.shape()))
+                    {
+                        REQUIRE(result == var);
+                        continue;
+                    }
+                    REQUIRE(result.len() == std::size(paths) * var.len());
+                    REQUIRE(result.bytes() == std::size(paths) * var.bytes());
+                    for (std::size_t i = 0; i < std::size(paths); i++)
+                        REQUIRE(std::memcmp(result.bytes_ptr() + i * var.bytes(), var.bytes_ptr(),
+                                    var.bytes())
+                            == 0);
+                }
+            }
+        }
+        WHEN("a file can't be loaded")
+        {
+            THEN("nothing is returned")
+            {
+                REQUIRE(cdf::io::load_many({ path, path + ".missing" }, names) == std::nullopt);
+            }
+        }
+        WHEN("a variable is missing")
+        {
+            THEN("an exception is thrown")
+            {
+                REQUIRE_THROWS_AS(cdf::io::load_many(paths, { "not a variable" }),
+                    std::invalid_argument);
+            }
+        }
+    }
+}
+
+SCENARIO("Loading cdf files through the header cache", "[CDF]")
+{
+    GIVEN("a cdf file and an empty cache directory")
+    {
+        auto file = GENERATE(as<std::string> {}, "a_cdf.cdf", "a_col_major_cdf.cdf",
+            "a_compressed_cdf.cdf", "a_cdf_with_compressed_vars.cdf",
+            "ge_k0_cpi_19921231_v02.cdf", "ia_k0_epi_19970102_v01.cdf");
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path);
+        REQUIRE(ref != std::nullopt);
+        const auto cache_dir = std::filesystem::temp_directory_path() / "cdfpp-header-cache-test";
+        std::filesystem::remove_all(cache_dir);
+        std::filesystem::create_directories(cache_dir);
+        cdf::io::header_cache::set_directory(cache_dir);
+        WHEN("loading it twice")
+        {
+            auto first = cdf::io::load(path);
+            const auto entries = std::distance(std::filesystem::directory_iterator { cache_dir },
+                std::filesystem::directory_iterator {});
+            auto second = cdf::io::load(path);
+            cdf::io::header_cache::set_directory({});
+            THEN("the second load comes from the cache and both match a regular load")
+            {
+                REQUIRE(first != std::nullopt);
+                REQUIRE(second != std::nullopt);
+                REQUIRE(entries == (ref->compression == cdf::cdf_compression_type::no_compression));
+                REQUIRE(second->lazy_loaded);
+                REQUIRE(*first == *ref);
+                REQUIRE(*second == *ref);
+            }
+        }
+        WHEN("the cache entry is corrupted")
+        {
+            REQUIRE(cdf::io::load(path) != std::nullopt);
+            for (const auto& entry : std::filesystem::directory_iterator { cache_dir })
+                std::filesystem::resize_file(entry.path(), 16);
+            auto cd = cdf::io::load(path);
+            cdf::io::header_cache::set_directory({});
+            THEN("the file is parsed again")
+            {
+                REQUIRE(cd != std::nullopt);
+                REQUIRE(*cd == *ref);
+            }
+        }
+        WHEN("any field of the cache entry is overwritten with a huge count")
+        {
+            REQUIRE(cdf::io::load(path) != std::nullopt);
+            std::vector<std::filesystem::path> entries;
+            for (const auto& entry : std::filesystem::directory_iterator { cache_dir })
+                entries.push_back(entry.path());
+            std::vector<std::string> contents;
+            for (const auto& entry : entries)
+            {
+                std::ifstream file { entry, std::ios::binary };
+                contents.emplace_back(std::istreambuf_iterator<char> { file },
+                    std::istreambuf_iterator<char> {});
+            }
+            bool all_loaded = true;
+            for (std::size_t index = 0; index < std::size(entries); index++)
+            {
+                const auto& content = contents[index];
+                for (std::size_t offset = 8; offset + 8 <= std::min(std::size(content), 2048UL);
+                     offset++)
+                {
+                    auto corrupted = content;
+                    std::memset(std::data(corrupted) + offset, 0x7f, 8);
+                    std::ofstream { entries[index], std::ios::binary | std::ios::trunc }
+                        << corrupted;
+                    all_loaded &= cdf::io::load(path) != std::nullopt;
+                }
+            }
+            cdf::io::header_cache::set_directory({});
+            THEN("every load falls back to parsing the file or gets a valid entry")
+            {
+                REQUIRE(all_loaded);
+            }
+        }
+        std::filesystem::remove_all(cache_dir);
+    }
+}
+
+SCENARIO("Lazily loaded values within a memory budget", "[CDF]")
+{
+    GIVEN("a lazily loaded cdf file which values can't be mapped")
+    {
+        auto file = GENERATE(
+            as<std::string> {}, "a_col_major_cdf.cdf", "a_cdf_with_compressed_vars.cdf");
+        auto path = std::string(DATA_PATH) + "/" + file;
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path, true, false);
+        REQUIRE(ref != std::nullopt);
+        auto cd = cdf::io::load(path);
+        REQUIRE(cd != std::nullopt);
+        cdf::memory_budget::reset_counters();
+        WHEN("the budget only fits one variable")
+        {
+            cdf::memory_budget::set_budget(1UL);
+            const auto& variables = std::as_const(cd->variables);
+            for (const auto& [name, var] : variables)
+            {
+                REQUIRE(var == ref->variables[name]);
+                REQUIRE(var.values_budgeted());
+                REQUIRE(cdf::memory_budget::usage().resident_count == 1UL);
+            }
+            for (const auto& [name, var] : variables)
+                REQUIRE(var == ref->variables[name]);
+            const auto usage = cdf::memory_budget::usage();
+            cdf::memory_budget::set_budget(0UL);
+            THEN("least recently used values are evicted and loaded again on access")
+            {
+                REQUIRE(usage.budget == 1UL);
+                REQUIRE(usage.loads == std::size(variables));
+                REQUIRE(usage.reloads == std::size(variables));
+                REQUIRE(usage.evictions == 2 * std::size(variables) - 1);
+                std::size_t loaded = 0UL;
+                for (const auto& [name, var] : variables)
+                    loaded += var.values_loaded();
+                REQUIRE(loaded == 1UL);
+            }
+        }
+        WHEN("two budgeted variables are compared while the budget only fits one of them")
+        {
+            auto other = cdf::io::load(path);
+            REQUIRE(other != std::nullopt);
+            cdf::memory_budget::set_budget(1UL);
+            const bool equal = *cd == *other;
+            const auto& name = std::cbegin(cd->variables)->first;
+            const auto& var = std::as_const(cd->variables).at(name);
+            const auto& other_var = std::as_const(other->variables).at(name);
+            const char* values = var.bytes_ptr();
+            const char* other_values = other_var.bytes_ptr();
+            const auto usage = cdf::memory_budget::usage();
+            cdf::memory_budget::set_budget(0UL);
+            THEN("values stay alive while they are referenced")
+            {
+                REQUIRE(equal);
+                REQUIRE(usage.resident_count == 1UL);
+                REQUIRE(std::memcmp(values, other_values, var.bytes()) == 0);
+                REQUIRE(var == ref->variables[name]);
+            }
+        }
+        WHEN("budgeted values are modified")
+        {
+            cdf::memory_budget::set_budget(1UL);
+            auto& var = cd->variables[std::cbegin(cd->variables)->first];
+            REQUIRE(std::as_const(var) == ref->variables[var.name()]);
+            REQUIRE(var.values_budgeted());
+            std::ignore = var.bytes_ptr();
+            cdf::memory_budget::set_budget(0UL);
+            THEN("they are taken out of the budget")
+            {
+                REQUIRE_FALSE(var.values_budgeted());
+                REQUIRE(var.values_loaded());
+                REQUIRE(cdf::memory_budget::usage().resident_count == 0UL);
+                REQUIRE(var == ref->variables[var.name()]);
+            }
+        }
+        WHEN("there is no budget")
+        {
+            for (const auto& [name, var] : std::as_const(cd->variables))
+                REQUIRE(var == ref->variables[name]);
+            THEN("values are not tracked")
+            {
+                for (const auto& [name, var] : cd->variables)
+                    REQUIRE_FALSE(var.values_budgeted());
+                REQUIRE(cdf::memory_budget::usage().loads == 0UL);
+            }
+        }
+    }
+}
+
+SCENARIO("Keeping column major values in file order", "[CDF]")
+{
+    GIVEN("a lazily loaded column major cdf file")
+    {
+        auto path = std::string(DATA_PATH) + "/a_col_major_cdf.cdf";
+        REQUIRE(file_exists(path));
+        auto ref = cdf::io::load(path, true, false);
+        REQUIRE(ref != std::nullopt);
+        auto cd = cdf::io::load(path);
+        REQUIRE(cd != std::nullopt);
+        std::size_t kept = 0UL;
+        for (auto& [name, var] : cd->variables)
+            kept += var.keep_column_major();
+        REQUIRE(kept != 0UL);
+        // compares each element of var through its strides to the row major reference
+        const auto same_elements = [](const cdf::Variable& var, const cdf::Variable& ref)
+        {
+            const auto& shape = ref.shape();
+            const auto strides = var.strides();
+            const auto element_size = cdf::cdf_type_size(ref.type());
+            std::vector<std::size_t> index(std::size(shape), 0UL);
+            for (auto flat = 0UL; flat < ref.bytes() / element_size; flat++)
+            {
+                std::size_t offset = 0UL;
+                for (auto dim = 0UL; dim < std::size(shape); dim++)
+                    offset += index[dim] * strides[dim];
+                if (std::memcmp(var.bytes_ptr() + offset, ref.bytes_ptr() + flat * element_size,
+                        element_size)
+                    != 0)
+                    return false;
+                for (auto dim = std::size(shape); dim-- > 0;)
+                {
+                    if (++index[dim] < shape[dim])
+                        break;
+                    index[dim] = 0UL;
+                }
+            }
+            return true;
+        };
+        WHEN("loading values kept in file order")
+        {
+            THEN("they have Fortran strides inside records and match row major values")
+            {
+                for (const auto& [name, var] : std::as_const(cd->variables))
+                {
+                    const auto& ref_var = ref->variables[name];
+                    if (var.values_column_major())
+                    {
+                        const auto strides = var.strides();
+                        const auto element_size = cdf::cdf_type_size(var.type());
+                        REQUIRE(strides[1] == element_size);
+                        REQUIRE(strides[2] == element_size * var.shape()[1]);
+                        REQUIRE(strides[0] == ref_var.bytes() / ref_var.len());
+                        REQUIRE(same_elements(var, ref_var));
+                    }
+                    else
+                        REQUIRE(var == ref_var);
+                }
+            }
+        }
+        WHEN("loading or copying a range of records")
+        {
+            THEN("slices keep file order and copies are row major")
+            {
+                for (const auto& [name, var] : std::as_const(cd->variables))
+                {
+                    const auto& ref_var = ref->variables[name];
+                    const auto len = ref_var.len();
+                    if (len == 0UL)
+                        continue;
+                    const auto slice = var.load_records(len / 3, len);
+                    REQUIRE(slice.values_column_major() == var.values_column_major());
+                    REQUIRE(same_elements(slice, ref_var.load_records(len / 3, len)));
+                    const auto record_bytes = ref_var.bytes() / len;
+                    std::vector<char> records((len - len / 3) * record_bytes);
+                    var.copy_records_to(records.data(), len / 3, len);
+                    REQUIRE(std::memcmp(records.data(),
+                                ref_var.bytes_ptr() + len / 3 * record_bytes, std::size(records))
+                        == 0);
+                    if (var.values_column_major())
+                        REQUIRE_FALSE(var.values_loaded());
+                }
+            }
+        }
+        WHEN("saving the file")
+        {
+            auto saved = cdf::io::save(*cd);
+            REQUIRE(std::size(saved) != 0UL);
+            THEN("values are written row major")
+            {
+                auto reloaded = cdf::io::load(std::data(saved), std::size(saved));
+                REQUIRE(reloaded != std::nullopt);
+                for (const auto& [name, var] : ref->variables)
+                    REQUIRE(reloaded->variables[name] == var);
+            }
+        }
+    }
+}
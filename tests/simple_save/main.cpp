@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <cstdint>
+#include <fstream>
+#include <iterator>
 #include <optional>
 #include <string>
 #include <tuple>
@@ -90,3 +92,151 @@ SCENARIO("Saving a cdf file", "[CDF]")
         REQUIRE(cdf_obj->variables.count("var1"));
     }
 }
+
+SCENARIO("Saving compressed variables with several threads", "[CDF]")
+{
+    GIVEN("a cdf with several compressed variables")
+    {
+        CDF cdf_obj;
+        for (const auto& [name, compression] :
+            { std::pair { "gzip_cos", cdf_compression_type::gzip_compression },
+                { "rle_cos", cdf_compression_type::rle_compression },
+                { "other_gzip_cos", cdf_compression_type::gzip_compression },
+                { "raw_cos", cdf_compression_type::no_compression } })
+        {
+            cdf_obj.variables.emplace(name,
+                Variable { name, std::size(cdf_obj.variables),
+                    data_t { cos_gen<double> { 0.01 }(30000), CDF_Types::CDF_DOUBLE },
+                    { 10000, 3 } });
+            cdf_obj.variables[name].set_compression_type(compression);
+        }
+        const auto serial = cdf::io::save(cdf_obj);
+        REQUIRE(std::size(serial) != 0UL);
+        WHEN("compressing them on several threads")
+        {
+            cdf::io::parallel::set_max_threads(4);
+            const auto parallel = cdf::io::save(cdf_obj);
+            cdf::io::parallel::set_max_threads(1);
+            THEN("the file is byte identical to a serial save")
+            {
+                REQUIRE(parallel == serial);
+                auto loaded = cdf::io::load(std::data(parallel), std::size(parallel));
+                REQUIRE(loaded != std::nullopt);
+                for (const auto& [name, variable] : cdf_obj.variables)
+                    REQUIRE(loaded->variables[name] == variable);
+            }
+        }
+        WHEN("saving them lazily loaded within a memory budget fitting one variable")
+        {
+            auto lazy = cdf::io::load(std::data(serial), std::size(serial), true, true);
+            REQUIRE(lazy != std::nullopt);
+            cdf::memory_budget::reset_counters();
+            cdf::memory_budget::set_budget(30000 * sizeof(double));
+            cdf::io::parallel::set_max_threads(4);
+            const auto budgeted = cdf::io::save(*lazy);
+            cdf::io::parallel::set_max_threads(1);
+            const auto usage = cdf::memory_budget::usage();
+            cdf::memory_budget::set_budget(0UL);
+            THEN("compressed variables are saved in batches fitting the budget")
+            {
+                REQUIRE(budgeted == serial);
+                REQUIRE(usage.resident_count == 1UL);
+                REQUIRE(usage.evictions >= 2UL);
+            }
+        }
+    }
+}
+
+SCENARIO("Saving compressed variables with a chunk policy", "[CDF]")
+{
+    GIVEN("a cdf with a compressed variable")
+    {
+        CDF cdf_obj;
+        cdf_obj.variables.emplace("gzip_cos",
+            Variable { "gzip_cos", 0,
+                data_t { cos_gen<double> { 0.01 }(30000), CDF_Types::CDF_DOUBLE },
+                { 10000, 3 } });
+        cdf_obj.variables["gzip_cos"].set_compression_type(cdf_compression_type::gzip_compression);
+        const auto single_chunk = cdf::io::save(cdf_obj);
+        REQUIRE(std::size(single_chunk) != 0UL);
+        WHEN("saving it with 1000 records per CVVR")
+        {
+            const auto chunked = cdf::io::save(cdf_obj, cdf::io::chunk_policy_t { .records = 1000 });
+            THEN("values are split in several CVVRs and load back unchanged")
+            {
+                REQUIRE(std::size(chunked) > std::size(single_chunk));
+                auto loaded = cdf::io::load(std::data(chunked), std::size(chunked), true, true);
+                REQUIRE(loaded != std::nullopt);
+                const auto& variable = loaded->variables["gzip_cos"];
+                const auto slice = variable.load_records(2500, 4500);
+                REQUIRE(slice.shape() == cdf::Variable::shape_t { 2000, 3 });
+                REQUIRE(std::equal(std::cbegin(slice.get<double>()), std::cend(slice.get<double>()),
+                    std::cbegin(cdf_obj.variables["gzip_cos"].get<double>()) + 2500 * 3));
+                REQUIRE(variable == cdf_obj.variables["gzip_cos"]);
+            }
+        }
+        WHEN("saving it with a byte target smaller than a record")
+        {
+            const auto chunked
+                = cdf::io::save(cdf_obj, cdf::io::chunk_policy_t { .target_bytes = 1 });
+            THEN("each CVVR still holds one record")
+            {
+                auto loaded = cdf::io::load(std::data(chunked), std::size(chunked));
+                REQUIRE(loaded != std::nullopt);
+                REQUIRE(loaded->variables["gzip_cos"] == cdf_obj.variables["gzip_cos"]);
+            }
+        }
+    }
+}
+
+SCENARIO("Saving a file with several threads", "[CDF]")
+{
+    GIVEN("a cdf with large and small variables")
+    {
+        CDF cdf_obj;
+        cdf_obj.attributes.emplace("some global attr",
+            cdf::Attribute { "some global attr",
+                { data_t { no_init_vector<double> { 1., 2., 3. }, CDF_Types::CDF_DOUBLE } } });
+        for (const auto& [name, compression, records] :
+            { std::tuple { "large_cos", cdf_compression_type::no_compression, 400000U },
+                { "other_large_cos", cdf_compression_type::no_compression, 50000U },
+                { "small_cos", cdf_compression_type::no_compression, 10U },
+                { "gzip_cos", cdf_compression_type::gzip_compression, 100000U } })
+        {
+            cdf_obj.variables.emplace(name,
+                Variable { name, std::size(cdf_obj.variables),
+                    data_t { cos_gen<double> { 0.01 }(records * 3), CDF_Types::CDF_DOUBLE },
+                    { records, 3 } });
+            cdf_obj.variables[name].set_compression_type(compression);
+        }
+        const auto in_memory = cdf::io::save(cdf_obj);
+        REQUIRE(std::size(in_memory) != 0UL);
+        WHEN("saving it to a file on several threads")
+        {
+            const std::string cdf_path = std::tmpnam(nullptr);
+            cdf::io::parallel::set_max_threads(4);
+            const auto saved = cdf::io::save(cdf_obj, cdf_path);
+            cdf::io::parallel::set_max_threads(1);
+            REQUIRE(saved);
+            THEN("the file is byte identical to an in memory save")
+            {
+                std::ifstream file { cdf_path, std::ios::binary };
+                const no_init_vector<char> content { std::istreambuf_iterator<char> { file },
+                    std::istreambuf_iterator<char> {} };
+                REQUIRE(content == in_memory);
+            }
+            AND_WHEN("saving it compressed as a whole")
+            {
+                cdf_obj.compression = cdf_compression_type::gzip_compression;
+                REQUIRE(cdf::io::save(cdf_obj, cdf_path));
+                THEN("it loads back unchanged")
+                {
+                    auto loaded = cdf::io::load(cdf_path);
+                    REQUIRE(loaded != std::nullopt);
+                    for (const auto& [name, variable] : cdf_obj.variables)
+                        REQUIRE(loaded->variables[name] == variable);
+                }
+            }
+        }
+    }
+}
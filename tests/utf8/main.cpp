@@ -0,0 +1,79 @@
+#include <catch2/catch_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "cdfpp/cdf-data.hpp"
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+
+/* byte per byte DFA, the reference for every validation path */
+bool reference_is_valid_utf8(const std::string& text)
+{
+    uint32_t state = 0;
+    uint32_t codepoint = 0;
+    for (const auto c : text)
+        std::tie(state, codepoint) = cdf::decode(state, codepoint, static_cast<uint8_t>(c));
+    return state == 0;
+}
+
+std::string reference_iso_8859_1_to_utf8(const std::string& text)
+{
+    std::string out;
+    for (const auto c : text)
+    {
+        const auto byte = static_cast<uint8_t>(c);
+        if (byte < 0x80)
+            out.push_back(c);
+        else
+        {
+            out.push_back(static_cast<char>(0xc0 | byte >> 6));
+            out.push_back(static_cast<char>(0x80 | (byte & 0x3f)));
+        }
+    }
+    return out;
+}
+
+SCENARIO("UTF-8 validation and latin1 transcoding", "[utf8]")
+{
+    GIVEN("a text made of ASCII, multi-bytes and invalid sequences")
+    {
+        // sizes cover the scalar path, SIMD blocks and their tails
+        const auto size = GENERATE(0UL, 7UL, 31UL, 63UL, 64UL, 65UL, 100UL, 1000UL);
+        const auto sequence = GENERATE(as<std::string> {}, "", "\xc3\xa9", "\xe2\x82\xac",
+            "\xf0\x9f\x98\x80", "\xc3", "\xe2\x82", "\x80", "\xb0", "\xed\xa0\x80", "\xc0\xaf",
+            "\xe0\x80\xaf", "\xf0\x80\x80\xaf", "\xf4\x90\x80\x80", "\xff");
+        const auto position = GENERATE(0UL, 1UL, 30UL, 31UL, 62UL, 999UL);
+        std::string text;
+        for (std::size_t i = 0; i < size; i++)
+            text.push_back(static_cast<char>('a' + i % 26));
+        if (position < size)
+            text.replace(position, std::size(sequence), sequence);
+        WHEN("validating it")
+        {
+            THEN("the result matches the byte per byte DFA")
+            {
+                REQUIRE(cdf::is_valid_utf8(text.data(), std::size(text))
+                    == reference_is_valid_utf8(text));
+            }
+        }
+        WHEN("converting it as latin1")
+        {
+            THEN("each byte above 0x7f is encoded on two bytes")
+            {
+                REQUIRE(cdf::iso_8859_1_to_utf8<std::string>(text.data(), std::size(text))
+                    == reference_iso_8859_1_to_utf8(text));
+            }
+        }
+        WHEN("ensuring it is UTF-8")
+        {
+            THEN("valid text is kept as is and latin1 text is converted")
+            {
+                const auto expected = reference_is_valid_utf8(text)
+                    ? text
+                    : reference_iso_8859_1_to_utf8(text);
+                REQUIRE(cdf::ensure_utf8<std::string>(text.data(), std::size(text)) == expected);
+            }
+        }
+    }
+}